@@ -0,0 +1,10 @@
+#pragma once
+
+/**
+ * Runs the headless octree benchmarks and logs their results.
+ *
+ * @return Whether every checked result, such as the vertex packing round trips, was within bounds.
+ *
+ * @remarks No GL context is created, so this can run on build machines.
+ */
+bool run_benchmarks();
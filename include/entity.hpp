@@ -6,4 +6,7 @@ struct movement {
 
 	float horizontalAngle = 0.0f;
 	float verticalAngle = 0.0f;
+
+	// displacement asked for by this frame's input, before it is clipped against the octree
+	glm::vec3 velocity = glm::vec3(0, 0, 0);
 };
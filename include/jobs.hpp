@@ -0,0 +1,206 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <framework.hpp>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace jobs
+{
+	/**
+	 * A fixed set of worker threads, each with its own task deque.
+	 *
+	 * @remarks Workers take their newest task first and, when their own deque is empty,
+	 *          steal the oldest task of another worker, so a burst of submissions spreads
+	 *          across the pool without everyone contending on a single queue.
+	 */
+	class pool
+	{
+public:
+		explicit pool(int worker_count = 0);
+		~pool();
+
+		pool(const pool &) = delete;
+		pool &operator=(const pool &) = delete;
+
+		void submit(std::function<void()> task);
+
+		[[nodiscard]] std::size_t size() const
+		{
+			return workers.size();
+		}
+
+private:
+		struct worker_queue {
+			std::mutex mutex;
+			std::deque<std::function<void()>> tasks;
+		};
+
+		std::vector<std::unique_ptr<worker_queue>> queues;
+		std::vector<std::thread> workers;
+
+		// sleeping workers wait here; queued counts tasks not yet taken by anyone
+		std::mutex sleep_mutex;
+		std::condition_variable wake;
+		std::atomic<std::size_t> queued = 0;
+		std::atomic<std::size_t> next_queue = 0;
+		bool stopping = false;
+
+		void work(std::size_t self);
+		bool try_take(std::size_t self, std::function<void()> &task);
+	};
+
+	enum class affinity
+	{
+		// any worker of the pool
+		any,
+
+		// the thread driving the frame, which owns the GL context, GLFW and ImGui
+		render
+	};
+
+	typedef std::function<void(const frame::tick_event &)> job_function;
+
+	/**
+	 * One system's share of a frame, and the registry context entries it touches.
+	 */
+	struct job {
+		std::string name;
+		affinity where = affinity::any;
+		job_function function;
+
+		std::vector<entt::id_type> reads;
+		std::vector<entt::id_type> writes;
+
+		template<typename Type>
+		job &reads_from()
+		{
+			return reads_from(entt::type_id<Type>().hash());
+		}
+
+		template<typename Type>
+		job &writes_to()
+		{
+			return writes_to(entt::type_id<Type>().hash());
+		}
+
+		// for entries placed with emplace_as under a name
+		job &reads_from(entt::id_type id)
+		{
+			reads.push_back(id);
+			return *this;
+		}
+
+		job &writes_to(entt::id_type id)
+		{
+			writes.push_back(id);
+			return *this;
+		}
+	};
+
+	struct job_timing {
+		// relative to the start of the frame
+		float start_ms = 0.0f;
+		float duration_ms = 0.0f;
+	};
+
+	struct graph_stats {
+		// from the first job starting to the last one finishing
+		float wall_ms = 0.0f;
+
+		// time spent in jobs, summed over every thread
+		float work_ms = 0.0f;
+
+		// the longest chain of dependent jobs, using this frame's durations
+		float critical_path_ms = 0.0f;
+
+		std::vector<job_timing> jobs;
+	};
+
+	/**
+	 * Runs each frame's systems as a dependency graph instead of one after another.
+	 *
+	 * @remarks A job depends on every job added before it that writes something it reads
+	 *          or writes, or reads something it writes, so the results match running the
+	 *          jobs in the order they were added. Jobs with no such conflict run at the
+	 *          same time on the pool. Render jobs additionally run in the order they were
+	 *          added, all on the thread that called run.
+	 */
+	class frame_graph
+	{
+public:
+		explicit frame_graph(int worker_count = 0);
+
+		frame_graph(const frame_graph &) = delete;
+		frame_graph &operator=(const frame_graph &) = delete;
+
+		/**
+		 * Adds a job to the end of the frame.
+		 *
+		 * @param name      Shown in the job timings.
+		 * @param where     Which thread the job may run on.
+		 * @param function  The work, called once per frame.
+		 * @return The job, to declare what it reads and writes on.
+		 */
+		job &add(std::string name, affinity where, job_function function);
+
+		/**
+		 * Runs every job once and returns when all of them have finished.
+		 */
+		void run(const frame::tick_event &event);
+
+		[[nodiscard]] const std::deque<job> &get_jobs() const
+		{
+			return jobs;
+		}
+
+		[[nodiscard]] const std::vector<std::vector<std::size_t>> &get_dependencies()
+		{
+			build();
+			return dependencies;
+		}
+
+		// the last finished frame
+		[[nodiscard]] const graph_stats &get_stats() const
+		{
+			return stats;
+		}
+
+private:
+		// a deque, so the job returned by add stays put while more are added
+		std::deque<job> jobs;
+
+		std::vector<std::vector<std::size_t>> dependencies;
+		std::vector<std::vector<std::size_t>> dependents;
+		bool built = false;
+
+		// per job, the dependencies that haven't finished yet this frame
+		std::unique_ptr<std::atomic<int>[]> remaining;
+		std::atomic<std::size_t> unfinished = 0;
+
+		std::vector<job_timing> timings;
+		std::chrono::steady_clock::time_point frame_start;
+
+		// jobs ready for the render thread
+		std::mutex render_mutex;
+		std::condition_variable render_ready;
+		std::deque<std::size_t> render_queue;
+
+		graph_stats stats;
+
+		// last, so its threads are joined before anything they touch is destroyed
+		pool workers;
+
+		void build();
+		void dispatch(std::size_t index, const frame::tick_event &event);
+		void execute(std::size_t index, const frame::tick_event &event);
+		void finish(std::size_t index, const frame::tick_event &event);
+		void measure();
+	};
+}
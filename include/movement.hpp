@@ -1,4 +1,4 @@
 #pragma once
-#include <entt/signal/fwd.hpp>
+#include <jobs.hpp>
 
-void register_input(entt::dispatcher &dispatcher);
+void register_input(jobs::frame_graph &graph);
@@ -1,5 +1,27 @@
 #pragma once
 #include "entt/entity/fwd.hpp"
-#include <entt/signal/fwd.hpp>
+#include <glm/glm.hpp>
+#include <jobs.hpp>
+#include <voxel/svo.hpp>
 
-void register_renderer(entt::registry &registry, entt::dispatcher &dispatcher);
+void register_renderer(entt::registry &registry, jobs::frame_graph &graph);
+
+/**
+ * Builds the octree the renderer draws.
+ */
+svo::svo create_scene();
+
+/**
+ * Casts the visibility fan from a camera and marks every node hit in a visibility set.
+ *
+ * @return The number of nodes newly marked.
+ *
+ * @remarks Touches no GL state and doesn't write to the octree, so the replay harness can
+ *          run it headless and the renderer can run it on a snapshot.
+ */
+int mark_visible(const svo::octree_view &svo, const glm::vec3 &position, const glm::vec3 &direction, svo::visibility_set &visible);
+
+/**
+ * Collects the voxels marked visible, at the renderer's level of detail.
+ */
+void collect_visible(const svo::octree_view &svo, const svo::visibility_set &visible, svo::voxel_set &voxels);
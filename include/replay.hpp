@@ -0,0 +1,53 @@
+#pragma once
+#include <entity.hpp>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace replay
+{
+	/**
+	 * Appends the camera's movement state to a path file once per frame.
+	 *
+	 * @remarks Each line holds one frame: position x y z, horizontal angle, vertical angle.
+	 */
+	class recorder
+	{
+public:
+		explicit recorder(const std::string &path);
+
+		void record(const movement &move);
+
+private:
+		std::ofstream out;
+	};
+
+	[[nodiscard]] std::vector<movement> load_path(const std::string &path);
+
+	/**
+	 * Parses a whole string as a number, without throwing on malformed input.
+	 *
+	 * @return Whether the string held exactly one number.
+	 */
+	[[nodiscard]] bool parse_number(std::string_view text, double &value);
+
+	/**
+	 * Replays a recorded path headless through visibility, collection and meshing.
+	 *
+	 * @param path    The recorded camera path.
+	 * @param report  Where to write per-frame phase timings; empty to only log the summary.
+	 * @return The process exit code.
+	 */
+	int run(const std::string &path, const std::string &report);
+
+	/**
+	 * Compares the tail latencies of two replay reports.
+	 *
+	 * @param baseline        The report of the reference run.
+	 * @param candidate       The report of the run being checked.
+	 * @param threshold_pct   How much any phase's p99 may grow before the diff fails.
+	 * @return Zero if no phase regressed past the threshold, one otherwise.
+	 */
+	int diff(const std::string &baseline, const std::string &candidate, double threshold_pct);
+}
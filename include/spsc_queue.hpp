@@ -0,0 +1,69 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+/**
+ * Bounded lock-free queue for exactly one producer thread and one consumer thread.
+ *
+ * @remarks Each side only ever writes its own index, so a push and a pop never
+ *          contend on the same atomic. Capacity must be a power of two.
+ */
+template<typename T, std::size_t Capacity>
+class spsc_queue
+{
+	static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "spsc_queue capacity must be a power of two");
+
+public:
+	/**
+	 * Pushes a value from the producer thread.
+	 *
+	 * @return False, leaving `value` untouched, if the queue is full.
+	 */
+	bool try_push(T &&value)
+	{
+		std::size_t tail = write_index.load(std::memory_order_relaxed);
+
+		if (tail - read_index.load(std::memory_order_acquire) == Capacity)
+		{
+			return false;
+		}
+
+		slots[tail & (Capacity - 1)] = std::move(value);
+		write_index.store(tail + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	/**
+	 * Pops a value from the consumer thread.
+	 */
+	std::optional<T> try_pop()
+	{
+		std::size_t head = read_index.load(std::memory_order_relaxed);
+
+		if (head == write_index.load(std::memory_order_acquire))
+		{
+			return std::nullopt;
+		}
+
+		std::optional<T> value(std::move(slots[head & (Capacity - 1)]));
+		read_index.store(head + 1, std::memory_order_release);
+
+		return value;
+	}
+
+	[[nodiscard]] bool empty() const
+	{
+		return read_index.load(std::memory_order_acquire) == write_index.load(std::memory_order_acquire);
+	}
+
+private:
+	std::array<T, Capacity> slots {};
+
+	// kept on separate cache lines so the two threads don't false-share
+	alignas(64) std::atomic<std::size_t> write_index = 0;
+	alignas(64) std::atomic<std::size_t> read_index = 0;
+};
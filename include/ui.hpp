@@ -1,4 +1,4 @@
 #pragma once
-#include <entt/signal/fwd.hpp>
+#include <jobs.hpp>
 
-void register_gui(entt::dispatcher &dispatcher);
+void register_gui(jobs::frame_graph &graph);
@@ -0,0 +1,88 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace svo
+{
+	/**
+	 * A 4x4x4 block of voxels stored in one leaf, as an occupancy mask and one packed color per occupied voxel.
+	 *
+	 * @remarks Voxel (x, y, z) is bit x | y << 2 | z << 4, so each run of four bits is one row
+	 *          along x. The colors are kept in bit order, so the color of a voxel is found by
+	 *          counting the occupied bits below it. Colors are quantized to RGBA8, so a color
+	 *          read back may differ from the one set by up to half an 8-bit step per channel.
+	 */
+	struct voxel_brick {
+		constexpr static int extent = 4;
+		constexpr static int voxel_count = extent * extent * extent;
+
+		std::uint64_t occupancy = 0;
+
+		// RGBA8, one per set bit of occupancy
+		std::vector<std::uint32_t> colors;
+
+		[[nodiscard]] constexpr static int bit(const glm::ivec3 &coord)
+		{
+			return coord.x | coord.y << 2 | coord.z << 4;
+		}
+
+		[[nodiscard]] constexpr static glm::ivec3 coord(int bit)
+		{
+			return glm::ivec3(bit & 3, (bit >> 2) & 3, (bit >> 4) & 3);
+		}
+
+		[[nodiscard]] bool contains(int bit) const
+		{
+			return (occupancy >> bit) & 1;
+		}
+
+		[[nodiscard]] bool full() const
+		{
+			return occupancy == ~std::uint64_t(0);
+		}
+
+		[[nodiscard]] int count() const
+		{
+			return std::popcount(occupancy);
+		}
+
+		// position of a voxel's color in colors, whether or not the voxel is occupied
+		[[nodiscard]] int attribute_index(int bit) const
+		{
+			return std::popcount(occupancy & ((std::uint64_t(1) << bit) - 1));
+		}
+
+		[[nodiscard]] glm::vec3 color(int bit) const
+		{
+			std::uint32_t packed = colors[attribute_index(bit)];
+
+			return glm::vec3(packed & 0xff, (packed >> 8) & 0xff, (packed >> 16) & 0xff) / 255.0f;
+		}
+
+		void set(int bit, const glm::vec3 &color)
+		{
+			glm::uvec3 scaled = glm::uvec3(glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f);
+			std::uint32_t packed = scaled.x | scaled.y << 8 | scaled.z << 16 | 0xffu << 24;
+
+			if (contains(bit))
+			{
+				colors[attribute_index(bit)] = packed;
+				return;
+			}
+
+			colors.insert(colors.begin() + attribute_index(bit), packed);
+			occupancy |= std::uint64_t(1) << bit;
+		}
+
+		void clear(int bit)
+		{
+			if (contains(bit))
+			{
+				colors.erase(colors.begin() + attribute_index(bit));
+				occupancy &= ~(std::uint64_t(1) << bit);
+			}
+		}
+	};
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <limits>
+
+namespace collision
+{
+	struct aabb final {
+public:
+		glm::vec3 min;
+		glm::vec3 max;
+
+		[[nodiscard]] static aabb from_center(const glm::vec3 &center, const glm::vec3 &half_extent)
+		{
+			return aabb { center - half_extent, center + half_extent };
+		}
+
+		[[nodiscard]] static aabb from_cube(const glm::vec3 &center, float size)
+		{
+			return from_center(center, glm::vec3(size * 0.5f));
+		}
+
+		[[nodiscard]] glm::vec3 center() const
+		{
+			return (min + max) * 0.5f;
+		}
+
+		[[nodiscard]] glm::vec3 half_extent() const
+		{
+			return (max - min) * 0.5f;
+		}
+
+		/**
+		 * Checks whether two boxes overlap.
+		 *
+		 * @remarks Boxes that only touch on a face do not count as overlapping,
+		 *          so a body resting against a voxel is free to slide along it.
+		 */
+		[[nodiscard]] bool overlaps(const aabb &other) const
+		{
+			return min.x < other.max.x && max.x > other.min.x
+					&& min.y < other.max.y && max.y > other.min.y
+					&& min.z < other.max.z && max.z > other.min.z;
+		}
+
+		/**
+		 * Returns the box covering this box over the whole of a move by `velocity`.
+		 */
+		[[nodiscard]] aabb swept(const glm::vec3 &velocity) const
+		{
+			return aabb { glm::min(min, min + velocity), glm::max(max, max + velocity) };
+		}
+
+		[[nodiscard]] float distance_squared(const glm::vec3 &point) const
+		{
+			glm::vec3 closest = glm::clamp(point, min, max);
+			glm::vec3 delta = point - closest;
+
+			return glm::dot(delta, delta);
+		}
+	};
+
+	struct sweep_result {
+		bool hit = false;
+		bool started_inside = false;
+
+		// fraction of the velocity travelled before contact, in [0, 1]
+		float time = 1.0f;
+		glm::vec3 normal = glm::vec3(0.0f);
+	};
+
+	/**
+	 * Sweeps a moving box against a static box.
+	 *
+	 * @param moving    The box at the start of the move.
+	 * @param velocity  The full displacement of the moving box.
+	 * @param target    The static box to test against.
+	 * @return The time of impact and the contact normal of `target`.
+	 *
+	 * @remarks This is a slab test of the moving box's center against `target`
+	 *          grown by the moving box's half extent. Boxes that already overlap
+	 *          report a hit at time zero with `started_inside` set.
+	 */
+	[[nodiscard]] inline sweep_result sweep(const aabb &moving, const glm::vec3 &velocity, const aabb &target)
+	{
+		sweep_result result;
+
+		float entry_time = -std::numeric_limits<float>::infinity();
+		float exit_time = std::numeric_limits<float>::infinity();
+		int entry_axis = -1;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float axis_entry;
+			float axis_exit;
+
+			if (velocity[axis] > 0.0f)
+			{
+				axis_entry = (target.min[axis] - moving.max[axis]) / velocity[axis];
+				axis_exit = (target.max[axis] - moving.min[axis]) / velocity[axis];
+			}
+			else if (velocity[axis] < 0.0f)
+			{
+				axis_entry = (target.max[axis] - moving.min[axis]) / velocity[axis];
+				axis_exit = (target.min[axis] - moving.max[axis]) / velocity[axis];
+			}
+			else
+			{
+				if (moving.max[axis] <= target.min[axis] || moving.min[axis] >= target.max[axis])
+				{
+					return result;
+				}
+
+				continue;
+			}
+
+			if (axis_entry > entry_time)
+			{
+				entry_time = axis_entry;
+				entry_axis = axis;
+			}
+
+			exit_time = std::min(exit_time, axis_exit);
+		}
+
+		if (entry_time >= exit_time || exit_time <= 0.0f || entry_time > 1.0f)
+		{
+			return result;
+		}
+
+		result.hit = true;
+
+		if (entry_time < 0.0f)
+		{
+			result.started_inside = true;
+			result.time = 0.0f;
+			return result;
+		}
+
+		result.time = entry_time;
+		result.normal[entry_axis] = velocity[entry_axis] > 0.0f ? -1.0f : 1.0f;
+
+		return result;
+	}
+}
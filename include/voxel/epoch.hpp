@@ -0,0 +1,112 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <thread>
+
+namespace svo
+{
+	/**
+	 * Hands out the latest published version of a structure to readers without locks, and
+	 * tells the writer which old versions are no longer being read.
+	 *
+	 * @remarks Epoch-based reclamation: every publish is numbered, and a reader announces the
+	 *          newest number in a slot of its own before it loads the current version, so the
+	 *          version it holds is never older than what it announced. Whatever the writer
+	 *          replaced in version n is unreachable from n onwards, and can be freed once no
+	 *          slot announces a number below n.
+	 */
+	template<typename Version>
+	class epoch_domain
+	{
+public:
+		constexpr static std::size_t max_readers = 64;
+
+		struct pin {
+			std::size_t slot;
+			const Version *version;
+		};
+
+		epoch_domain()
+		{
+			for (auto &slot : slots)
+			{
+				slot.store(idle, std::memory_order_relaxed);
+			}
+		}
+
+		epoch_domain(const epoch_domain &) = delete;
+		epoch_domain &operator=(const epoch_domain &) = delete;
+
+		/**
+		 * Claims a reader slot and loads the current version.
+		 *
+		 * @remarks Only waits when all max_readers slots are taken at once.
+		 */
+		pin enter()
+		{
+			while (true)
+			{
+				for (std::size_t i = 0; i < max_readers; i++)
+				{
+					std::uint64_t expected = idle;
+
+					// the announcement has to be visible before the version is loaded, so both are sequentially consistent
+					if (slots[i].compare_exchange_strong(expected, published.load()))
+					{
+						return pin { i, current.load() };
+					}
+				}
+
+				std::this_thread::yield();
+			}
+		}
+
+		void leave(std::size_t slot)
+		{
+			slots[slot].store(idle, std::memory_order_release);
+		}
+
+		/**
+		 * Makes a version current for readers that enter from now on.
+		 *
+		 * @return The version's number, one more than the previous one's.
+		 */
+		std::uint64_t publish(const Version *version)
+		{
+			current.store(version);
+
+			const std::uint64_t number = published.load(std::memory_order_relaxed) + 1;
+			published.store(number);
+
+			return number;
+		}
+
+		/**
+		 * Returns the lowest version number any reader may still hold.
+		 */
+		[[nodiscard]] std::uint64_t oldest_read() const
+		{
+			std::uint64_t oldest = published.load();
+
+			for (const auto &slot : slots)
+			{
+				oldest = std::min(oldest, slot.load());
+			}
+
+			return oldest;
+		}
+
+private:
+		constexpr static std::uint64_t idle = std::numeric_limits<std::uint64_t>::max();
+
+		std::atomic<const Version *> current = nullptr;
+		std::atomic<std::uint64_t> published = 0;
+
+		// the number each reader announced on entering, or idle
+		std::array<std::atomic<std::uint64_t>, max_readers> slots;
+	};
+}
@@ -0,0 +1,151 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <spsc_queue.hpp>
+#include <thread>
+#include <voxel/svo.hpp>
+
+namespace svo
+{
+	/**
+	 * A finished mesh in whichever vertex format it was requested in.
+	 */
+	struct staged_mesh {
+		vertex_format format = vertex_format::full;
+
+		mesh_data full;
+		compact_mesh compact;
+		instance_mesh instanced;
+	};
+
+	struct mesh_stats {
+		// frames between a visible set being submitted and its mesh being uploaded
+		int last_latency_frames = 0;
+		int max_latency_frames = 0;
+		float average_latency_frames = 0.0f;
+
+		std::size_t meshes_uploaded = 0;
+
+		// frames that had to redraw an older mesh because no newer one was ready
+		std::size_t stale_frames = 0;
+
+		// visible sets not meshed: rejected because the queue was full, or replaced by a newer one
+		std::size_t dropped_snapshots = 0;
+		std::size_t superseded_snapshots = 0;
+
+		float last_upload_ms = 0.0f;
+	};
+
+	/**
+	 * Builds meshes for snapshots of the visible set on a worker thread.
+	 *
+	 * @remarks The render thread submits snapshots and consumes finished meshes; the
+	 *          worker fills one of two staging meshes while the render thread uploads
+	 *          the other. The threads only communicate through single-producer,
+	 *          single-consumer queues, so neither ever takes a lock.
+	 */
+	class mesh_pipeline
+	{
+public:
+		mesh_pipeline();
+		~mesh_pipeline();
+
+		mesh_pipeline(const mesh_pipeline &) = delete;
+		mesh_pipeline &operator=(const mesh_pipeline &) = delete;
+
+		/**
+		 * Hands a snapshot of the visible voxels to the worker.
+		 *
+		 * @param voxels  The visible set; copied by value, so the tree may change afterwards.
+		 * @param frame   The frame the snapshot was taken on, used for latency metrics.
+		 * @param format  The vertex format to build the mesh in.
+		 * @return False if the worker is too far behind and the snapshot was dropped.
+		 */
+		bool submit(voxel_set &&voxels, int frame, vertex_format format = vertex_format::full);
+
+		/**
+		 * Uploads the newest finished mesh, if there is one.
+		 *
+		 * @param frame   The current frame, used for latency metrics.
+		 * @param upload  Called with the mesh on the calling thread, e.g. to copy it into GL buffers.
+		 * @return False if no new mesh was ready and the previous one should be drawn again.
+		 */
+		template<typename Upload>
+		bool consume(int frame, Upload &&upload)
+		{
+			std::optional<completed_mesh> newest;
+
+			while (auto next = ready.try_pop())
+			{
+				if (newest)
+				{
+					release(newest->slot);
+				}
+
+				newest = next;
+			}
+
+			if (!newest)
+			{
+				if (submitted)
+				{
+					stats.stale_frames++;
+				}
+
+				return false;
+			}
+
+			auto start = std::chrono::steady_clock::now();
+			upload(static_cast<const staged_mesh &>(staging[newest->slot]));
+			stats.last_upload_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			release(newest->slot);
+			record_latency(frame - newest->frame);
+
+			return true;
+		}
+
+		[[nodiscard]] const mesh_stats &get_stats()
+		{
+			stats.superseded_snapshots = superseded.load(std::memory_order_relaxed);
+			return stats;
+		}
+
+private:
+		struct mesh_request {
+			voxel_set voxels;
+			int frame = 0;
+			vertex_format format = vertex_format::full;
+		};
+
+		struct completed_mesh {
+			int slot = 0;
+			int frame = 0;
+		};
+
+		// render thread -> worker
+		spsc_queue<mesh_request, 4> requests;
+		spsc_queue<int, 2> free_slots;
+
+		// worker -> render thread
+		spsc_queue<completed_mesh, 2> ready;
+
+		staged_mesh staging[2];
+
+		std::atomic<std::uint32_t> signal = 0;
+		std::atomic<bool> stopping = false;
+		std::atomic<std::size_t> superseded = 0;
+		std::thread worker;
+
+		mesh_stats stats;
+		bool submitted = false;
+		double total_latency_frames = 0.0;
+
+		void work();
+		void wake();
+		void release(int slot);
+		void record_latency(int frames);
+	};
+}
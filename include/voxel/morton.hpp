@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace morton
+{
+	// deepest level whose coordinates still fit, with the level marker bit, in a 64 bit key
+	constexpr int max_level = 20;
+
+	/**
+	 * Spreads the low 21 bits of a value so that two zero bits follow each of them.
+	 */
+	[[nodiscard]] constexpr std::uint64_t spread(std::uint32_t value)
+	{
+		std::uint64_t x = value & 0x1fffff;
+
+		x = (x | x << 32) & 0x1f00000000ffff;
+		x = (x | x << 16) & 0x1f0000ff0000ff;
+		x = (x | x << 8) & 0x100f00f00f00f00f;
+		x = (x | x << 4) & 0x10c30c30c30c30c3;
+		x = (x | x << 2) & 0x1249249249249249;
+
+		return x;
+	}
+
+	/**
+	 * Inverse of spread, gathering every third bit back into the low 21 bits.
+	 */
+	[[nodiscard]] constexpr std::uint32_t compact(std::uint64_t value)
+	{
+		std::uint64_t x = value & 0x1249249249249249;
+
+		x = (x | x >> 2) & 0x10c30c30c30c30c3;
+		x = (x | x >> 4) & 0x100f00f00f00f00f;
+		x = (x | x >> 8) & 0x1f0000ff0000ff;
+		x = (x | x >> 16) & 0x1f00000000ffff;
+		x = (x | x >> 32) & 0x1fffff;
+
+		return static_cast<std::uint32_t>(x);
+	}
+
+	/**
+	 * Interleaves a lattice coordinate into a Morton code, x in the lowest bit.
+	 *
+	 * @remarks The bit order matches the child index used by svo::node, so the
+	 *          low three bits of a node's code are its index in its parent.
+	 */
+	[[nodiscard]] constexpr std::uint64_t encode(const glm::ivec3 &coord)
+	{
+		return spread(coord.x) | spread(coord.y) << 1 | spread(coord.z) << 2;
+	}
+
+	[[nodiscard]] constexpr glm::ivec3 decode(std::uint64_t code)
+	{
+		return glm::ivec3(compact(code), compact(code >> 1), compact(code >> 2));
+	}
+
+	/**
+	 * Builds the locational key of a node from its level and lattice coordinate.
+	 *
+	 * @remarks A marker bit above the Morton code keeps keys of different
+	 *          levels distinct and guarantees no valid key is ever zero.
+	 */
+	[[nodiscard]] constexpr std::uint64_t key(int level, const glm::ivec3 &coord)
+	{
+		return (std::uint64_t(1) << (3 * level)) | encode(coord);
+	}
+}
@@ -0,0 +1,192 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace svo
+{
+	struct node;
+
+	/**
+	 * Open-addressing hash map from a node's locational key to the node.
+	 *
+	 * @remarks Uses linear probing with backward-shift deletion, so there are no
+	 *          tombstones and lookups stay short however many edits are applied.
+	 *          A key of zero marks an empty slot, which morton::key never produces.
+	 */
+	class node_index
+	{
+public:
+		[[nodiscard]] node *find(std::uint64_t key) const
+		{
+			if (slots.empty())
+			{
+				return nullptr;
+			}
+
+			for (std::size_t i = hash(key) & mask();; i = (i + 1) & mask())
+			{
+				if (slots[i].key == key)
+				{
+					return slots[i].value;
+				}
+
+				if (slots[i].key == 0)
+				{
+					return nullptr;
+				}
+			}
+		}
+
+		/**
+		 * Inserts a node, replacing whatever was stored under the same key.
+		 */
+		void insert(std::uint64_t key, node *value)
+		{
+			if ((count + 1) * 2 > slots.size())
+			{
+				grow();
+			}
+
+			std::size_t i = hash(key) & mask();
+
+			while (slots[i].key != 0 && slots[i].key != key)
+			{
+				i = (i + 1) & mask();
+			}
+
+			if (slots[i].key == 0)
+			{
+				count++;
+			}
+
+			slots[i] = slot { key, value };
+		}
+
+		bool erase(std::uint64_t key)
+		{
+			if (slots.empty())
+			{
+				return false;
+			}
+
+			std::size_t i = hash(key) & mask();
+
+			while (slots[i].key != key)
+			{
+				if (slots[i].key == 0)
+				{
+					return false;
+				}
+
+				i = (i + 1) & mask();
+			}
+
+			// shift later entries of the probe run back so no lookup stops early at the hole
+			for (std::size_t j = (i + 1) & mask(); slots[j].key != 0; j = (j + 1) & mask())
+			{
+				std::size_t home = hash(slots[j].key) & mask();
+
+				if (((j - home) & mask()) >= ((j - i) & mask()))
+				{
+					slots[i] = slots[j];
+					i = j;
+				}
+			}
+
+			slots[i] = slot {};
+			count--;
+
+			return true;
+		}
+
+		void clear()
+		{
+			slots.clear();
+			count = 0;
+		}
+
+		[[nodiscard]] std::size_t size() const
+		{
+			return count;
+		}
+
+		[[nodiscard]] std::size_t capacity() const
+		{
+			return slots.size();
+		}
+
+		/**
+		 * Rehashes into the smallest table that keeps the load factor at or under one half.
+		 *
+		 * @remarks Erasing never shrinks the table, so callers that remove most of
+		 *          the nodes at once call this afterwards to give the memory back.
+		 */
+		void shrink()
+		{
+			std::size_t capacity = 64;
+
+			while (count * 2 > capacity)
+			{
+				capacity *= 2;
+			}
+
+			if (capacity < slots.size())
+			{
+				rehash(capacity);
+			}
+		}
+
+		[[nodiscard]] std::size_t memory_usage() const
+		{
+			return slots.capacity() * sizeof(slot);
+		}
+
+private:
+		struct slot {
+			std::uint64_t key = 0;
+			node *value = nullptr;
+		};
+
+		std::vector<slot> slots;
+		std::size_t count = 0;
+
+		[[nodiscard]] std::size_t mask() const
+		{
+			return slots.size() - 1;
+		}
+
+		[[nodiscard]] static std::size_t hash(std::uint64_t key)
+		{
+			// splitmix64 finalizer; Morton codes of neighbours differ only in a few low bits
+			key ^= key >> 30;
+			key *= 0xbf58476d1ce4e5b9;
+			key ^= key >> 27;
+			key *= 0x94d049bb133111eb;
+			key ^= key >> 31;
+
+			return static_cast<std::size_t>(key);
+		}
+
+		void grow()
+		{
+			rehash(slots.empty() ? 64 : slots.size() * 2);
+		}
+
+		void rehash(std::size_t capacity)
+		{
+			std::vector<slot> old = std::move(slots);
+
+			slots.assign(capacity, slot {});
+			count = 0;
+
+			for (const auto &entry : old)
+			{
+				if (entry.key != 0)
+				{
+					insert(entry.key, entry.value);
+				}
+			}
+		}
+	};
+}
@@ -1,9 +1,25 @@
 #pragma once
+#include <algorithm>
+#include <array>
 #include <buffer.hpp>
+#include <chrono>
+#include <deque>
+#include <future>
 #include <glm/glm.hpp>
+#include <limits>
+#include <memory>
 #include <render.hpp>
+#include <span>
 #include <unordered_set>
+#include <utility>
+#include <voxel/brick.hpp>
+#include <voxel/collision.hpp>
+#include <voxel/epoch.hpp>
+#include <voxel/morton.hpp>
+#include <voxel/node_index.hpp>
 #include <voxel/ray.hpp>
+#include <voxel/vertex_format.hpp>
+#include <voxel/vertex_layout.hpp>
 
 namespace svo
 {
@@ -17,42 +33,106 @@ namespace svo
 		glm::vec3 position;
 		voxel voxels[8];
 
+		// only the editing svo follows parent links: a subtree shared between versions
+		// points at whichever of its parents was copied last
 		node *parent = nullptr;
 		node *children[8] = { nullptr };
 
-		int draw_turn = -1;
+		// level below the root and position on that level's lattice, as used by svo::find
+		int depth = 0;
+		glm::ivec3 coord = glm::ivec3(0);
 
-		void set_draw_turn(int turn, int depth)
+		// summary of the subtree, kept up to date by svo::reduce_attributes and the edit functions
+		std::uint8_t child_mask = 0;
+		float coverage = 0.0f;
+		glm::vec3 average_color = glm::vec3(0.0f);
+
+		// for each empty child slot, how far the empty space around it reaches in every direction,
+		// in eighths of the child's cell; never more than the true distance, 0 if unknown
+		std::uint8_t child_distance[8] = { 0 };
+
+		// set on leaves made by svo::build_bricks, which hold the two levels below them
+		// as a brick instead of as nodes; voxels[0] still describes the leaf's own cell.
+		// Never changed once packed, so copies of the leaf share it
+		std::shared_ptr<const voxel_brick> brick;
+
+		// the svo's editing round that made this node; nodes from earlier rounds have
+		// been published and are copied rather than written to
+		std::uint64_t version = 0;
+
+		[[nodiscard]] std::uint64_t key() const
 		{
-			this->draw_turn = turn;
+			return morton::key(depth, coord);
+		}
 
-			if (parent)
-			{
-				parent->set_draw_turn(turn, 0);
-			}
+		[[nodiscard]] bool is_leaf() const
+		{
+			return std::none_of(std::begin(children), std::end(children), [](const node *child) { return child != nullptr; });
+		}
 
-			if (depth != 0)
-			{
-				for (node *child : children)
-				{
-					if (child)
-					{
-						child->set_draw_turn(turn, depth - 1);
-					}
-				}
-			}
+		// which of its parent's child slots the node sits in
+		[[nodiscard]] int slot() const
+		{
+			const glm::ivec3 bit = coord & 1;
+			return bit.x | bit.y << 1 | bit.z << 2;
 		}
 	};
 
+	enum class face
+	{
+		neg_x,
+		pos_x,
+		neg_y,
+		pos_y,
+		neg_z,
+		pos_z
+	};
+
 	struct march_result {
 		bool hit = false;
 		float distance;
 		svo::node *node;
-		const svo::voxel *voxel;
+		svo::voxel voxel {};
+
+		// lattice cells visited on the way, counting each skipped empty region as one
+		int steps = 0;
+	};
+
+	struct collision_result {
+		bool hit = false;
+
+		// fraction of the requested velocity that can be travelled before contact
+		float time = 1.0f;
+		glm::vec3 normal = glm::vec3(0.0f);
+
+		svo::node *node = nullptr;
+		svo::voxel voxel {};
+	};
+
+	struct nearest_result {
+		bool hit = false;
+		float distance = std::numeric_limits<float>::max();
+
+		svo::node *node = nullptr;
+		svo::voxel voxel {};
+	};
+
+	struct sweep_query {
+		collision::aabb box;
+		glm::vec3 velocity;
 	};
 
 	typedef std::vector<voxel> voxel_set;
 
+	// keys of the nodes marked visible, kept apart from the nodes so marking never writes to the tree
+	typedef std::unordered_set<std::uint64_t> visibility_set;
+
+	struct mesh_data {
+		std::vector<glm::vec3> vertices;
+		std::vector<glm::vec3> colors;
+		std::vector<unsigned int> indices;
+	};
+
 	class grid_buffer
 	{
 private:
@@ -60,373 +140,2711 @@ private:
 		buffer::buffer *color_buffer;
 		buffer::buffer *index_buffer;
 
-public:
-		grid_buffer(glm::vec3 bounds)
-		{
-			vertex_buffer = new buffer::buffer(nullptr, 0, draw_type::dynamic_draw, buffer_type::array);
-			color_buffer = new buffer::buffer(nullptr, 0, draw_type::dynamic_draw, buffer_type::array);
-			index_buffer = new buffer::buffer(nullptr, 0, draw_type::dynamic_draw, buffer_type::array);
+		// interleaved stream used by the compact vertex formats
+		buffer::buffer *packed_buffer;
+
+		// per-voxel records and the one cube they are drawn with, used by the instanced format
+		buffer::buffer *instance_buffer;
+		buffer::buffer *cube_vertex_buffer;
+		buffer::buffer *cube_index_buffer;
+		size_t instance_count = 0;
+
+		vertex_format format = vertex_format::full;
+		quantization lattice;
+		size_t uploaded_bytes = 0;
+
+		static constexpr size_t cube_vertex_count = 36;
+
+		// corners of a unit cube, as offsets of half a voxel from its center
+		static constexpr int cube_corners[8][3] = {
+			{ -1, -1, -1 },
+			{ 1, -1, -1 },
+			{ 1, 1, -1 },
+			{ -1, 1, -1 },
+			{ -1, -1, 1 },
+			{ 1, -1, 1 },
+			{ 1, 1, 1 },
+			{ -1, 1, 1 }
+		};
+
+		// Define the indices for the cube
+		static constexpr unsigned int cube_indices[cube_vertex_count] = {
+			0, 1, 2, 2, 3, 0, // front face
+			1, 5, 6, 6, 2, 1, // right face
+			5, 4, 7, 7, 6, 5, // back face
+			4, 0, 3, 3, 7, 4, // left face
+			3, 2, 6, 6, 7, 3, // top face
+			4, 5, 1, 1, 0, 4 // bottom face
+		};
+
+public:
+		grid_buffer(glm::vec3 bounds)
+				: vertex_buffer(nullptr)
+				, color_buffer(nullptr)
+				, index_buffer(nullptr)
+				, packed_buffer(nullptr)
+				, instance_buffer(nullptr)
+				, cube_vertex_buffer(nullptr)
+				, cube_index_buffer(nullptr)
+		{
+		}
+
+		// the GL buffers have one owner; moving hands them over and leaves the source without any
+		grid_buffer(const grid_buffer &) = delete;
+		grid_buffer &operator=(const grid_buffer &) = delete;
+
+		grid_buffer(grid_buffer &&other) noexcept
+				: vertex_buffer(std::exchange(other.vertex_buffer, nullptr))
+				, color_buffer(std::exchange(other.color_buffer, nullptr))
+				, index_buffer(std::exchange(other.index_buffer, nullptr))
+				, packed_buffer(std::exchange(other.packed_buffer, nullptr))
+				, instance_buffer(std::exchange(other.instance_buffer, nullptr))
+				, cube_vertex_buffer(std::exchange(other.cube_vertex_buffer, nullptr))
+				, cube_index_buffer(std::exchange(other.cube_index_buffer, nullptr))
+				, instance_count(std::exchange(other.instance_count, 0))
+				, format(other.format)
+				, lattice(other.lattice)
+				, uploaded_bytes(std::exchange(other.uploaded_bytes, 0))
+		{
+		}
+
+		grid_buffer &operator=(grid_buffer &&other) noexcept
+		{
+			if (this != &other)
+			{
+				destroy_buffers();
+
+				vertex_buffer = std::exchange(other.vertex_buffer, nullptr);
+				color_buffer = std::exchange(other.color_buffer, nullptr);
+				index_buffer = std::exchange(other.index_buffer, nullptr);
+				packed_buffer = std::exchange(other.packed_buffer, nullptr);
+				instance_buffer = std::exchange(other.instance_buffer, nullptr);
+				cube_vertex_buffer = std::exchange(other.cube_vertex_buffer, nullptr);
+				cube_index_buffer = std::exchange(other.cube_index_buffer, nullptr);
+				instance_count = std::exchange(other.instance_count, 0);
+				format = other.format;
+				lattice = other.lattice;
+				uploaded_bytes = std::exchange(other.uploaded_bytes, 0);
+			}
+
+			return *this;
+		}
+
+		/**
+		 * Creates the GL buffers on first use.
+		 *
+		 * @remarks This is deferred so an svo can be built without a GL context,
+		 *          e.g. on a worker thread or in a headless benchmark.
+		 */
+		void create_buffers()
+		{
+			if (vertex_buffer)
+			{
+				return;
+			}
+
+			vertex_buffer = new buffer::buffer(nullptr, 0, draw_type::dynamic_draw, buffer_type::array);
+			color_buffer = new buffer::buffer(nullptr, 0, draw_type::dynamic_draw, buffer_type::array);
+			index_buffer = new buffer::buffer(nullptr, 0, draw_type::dynamic_draw, buffer_type::array);
+			packed_buffer = new buffer::buffer(nullptr, 0, draw_type::dynamic_draw, buffer_type::array);
+			instance_buffer = new buffer::buffer(nullptr, 0, draw_type::dynamic_draw, buffer_type::array);
+
+			// the instanced cube never changes, so it is written once here
+			glm::vec3 corners[8];
+
+			for (int c = 0; c < 8; c++)
+			{
+				corners[c] = glm::vec3(cube_corners[c][0], cube_corners[c][1], cube_corners[c][2]);
+			}
+
+			cube_vertex_buffer = new buffer::buffer(nullptr, 0, draw_type::dynamic_draw, buffer_type::array);
+			cube_vertex_buffer->resize(sizeof(corners));
+			cube_vertex_buffer->write(corners, sizeof(corners), 0);
+
+			cube_index_buffer = new buffer::buffer(nullptr, 0, draw_type::dynamic_draw, buffer_type::array);
+			cube_index_buffer->resize(sizeof(cube_indices));
+			cube_index_buffer->update(cube_indices);
+		}
+
+		/**
+		 * Expands voxels into cube vertices on the CPU.
+		 *
+		 * @param data  The voxels to mesh.
+		 * @return The vertex, color and index streams ready for upload.
+		 *
+		 * @remarks This touches no GL state, so it can run on any thread.
+		 */
+		static mesh_data build_mesh(const voxel_set &data)
+		{
+			mesh_data mesh;
+			build_mesh(data, mesh);
+
+			return mesh;
+		}
+
+		/**
+		 * Expands voxels into cube vertices, reusing the storage of an existing mesh.
+		 */
+		static void build_mesh(const voxel_set &data, mesh_data &mesh)
+		{
+			mesh.vertices.clear();
+			mesh.colors.clear();
+			mesh.indices.clear();
+
+			mesh.vertices.reserve(cube_vertex_count * data.size());
+			mesh.colors.reserve(cube_vertex_count * data.size());
+			mesh.indices.reserve(cube_vertex_count * data.size());
+
+			for (const auto &voxel : data)
+			{
+				const float half_size = voxel.size / 2;
+
+				for (size_t i = 0; i < cube_vertex_count; i++)
+				{
+					const int *corner = cube_corners[cube_indices[i]];
+
+					mesh.indices.push_back(static_cast<unsigned int>(mesh.vertices.size()));
+					mesh.vertices.push_back(voxel.position + glm::vec3(corner[0], corner[1], corner[2]) * half_size);
+					mesh.colors.push_back(voxel.color);
+				}
+			}
+		}
+
+		/**
+		 * Expands voxels into cube vertices in one of the compact vertex formats.
+		 *
+		 * @param data    The voxels to mesh.
+		 * @param format  compact_16 or compact_10_10_10.
+		 * @param mesh    Receives the interleaved vertices and the lattice they are stored on.
+		 *
+		 * @remarks Cube corners sit on a lattice of half the smallest voxel size, so positions
+		 *          are stored exactly whenever that lattice fits the format's range across the
+		 *          mesh; otherwise the lattice is stretched to fit and positions are rounded.
+		 */
+		static void pack_mesh(const voxel_set &data, vertex_format format, compact_mesh &mesh)
+		{
+			mesh.format = format;
+			mesh.vertices.clear();
+			mesh.indices.clear();
+
+			if (data.empty())
+			{
+				return;
+			}
+
+			float max_coord = static_cast<float>(max_lattice_coord(format));
+			mesh.lattice = fit_lattice(data, max_coord);
+
+			const size_t stride = vertex_stride(format);
+
+			mesh.vertices.resize(cube_vertex_count * data.size() * stride);
+			mesh.indices.reserve(cube_vertex_count * data.size());
+
+			std::byte *out = mesh.vertices.data();
+
+			std::byte corners[8][16];
+
+			for (const auto &voxel : data)
+			{
+				const float half_size = voxel.size / 2;
+
+				// pack the eight corners once, then copy them out per triangle vertex
+				for (int c = 0; c < 8; c++)
+				{
+					const int *corner = cube_corners[c];
+					glm::vec3 position = voxel.position + glm::vec3(corner[0], corner[1], corner[2]) * half_size;
+					glm::vec3 coord = glm::round((position - mesh.lattice.origin) / mesh.lattice.scale);
+
+					pack_vertex(corners[c], format, glm::uvec3(glm::clamp(coord, 0.0f, max_coord)), voxel.color);
+				}
+
+				for (size_t i = 0; i < cube_vertex_count; i++, out += stride)
+				{
+					std::memcpy(out, corners[cube_indices[i]], stride);
+					mesh.indices.push_back(static_cast<unsigned int>(mesh.indices.size()));
+				}
+			}
+		}
+
+		/**
+		 * Packs voxels into one instance record each, for drawing a single cube per voxel.
+		 *
+		 * @param data  The voxels to pack, e.g. as collected by svo::get_voxels_with_depth.
+		 * @param mesh  Receives the instance records and the lattice they are stored on.
+		 *
+		 * @remarks Uses the same lattice as pack_mesh, so positions and sizes are exact
+		 *          under the same conditions; the cube corners are expanded by the GPU.
+		 */
+		static void pack_instances(const voxel_set &data, instance_mesh &mesh)
+		{
+			mesh.instances.clear();
+
+			if (data.empty())
+			{
+				return;
+			}
+
+			float max_coord = static_cast<float>(max_lattice_coord(vertex_format::instanced));
+			mesh.lattice = fit_lattice(data, max_coord);
+
+			mesh.instances.reserve(data.size());
+
+			for (const auto &voxel : data)
+			{
+				glm::vec3 coord = glm::round((voxel.position - mesh.lattice.origin) / mesh.lattice.scale);
+				float size = std::round(voxel.size / mesh.lattice.scale);
+
+				mesh.instances.push_back(pack_instance(glm::uvec3(glm::clamp(coord, 0.0f, max_coord)),
+						static_cast<std::uint32_t>(std::clamp(size, 0.0f, max_coord)), voxel.color));
+			}
+		}
+
+		/**
+		 * Uploads a mesh built by build_mesh, replacing the current contents.
+		 *
+		 * @remarks Must be called on the thread owning the GL context.
+		 */
+		void upload(const mesh_data &mesh)
+		{
+			create_buffers();
+
+			size_t type_size = sizeof(glm::vec3);
+
+			// Resize the buffers and allocate memory
+			vertex_buffer->resize(mesh.vertices.size() * type_size);
+			color_buffer->resize(mesh.colors.size() * type_size);
+			index_buffer->resize(mesh.indices.size() * sizeof(unsigned int));
+
+			if (!mesh.indices.empty())
+			{
+				vertex_buffer->write(mesh.vertices.data(), mesh.vertices.size() * type_size, 0);
+				color_buffer->write(mesh.colors.data(), mesh.colors.size() * type_size, 0);
+
+				// Update the index buffer with the new indices
+				index_buffer->update(mesh.indices.data());
+			}
+
+			format = vertex_format::full;
+			uploaded_bytes = mesh.vertices.size() * type_size * 2 + mesh.indices.size() * sizeof(unsigned int);
+		}
+
+		/**
+		 * Uploads a mesh built by pack_mesh, replacing the current contents.
+		 *
+		 * @remarks Must be called on the thread owning the GL context.
+		 */
+		void upload(const compact_mesh &mesh)
+		{
+			create_buffers();
+
+			packed_buffer->resize(mesh.vertices.size());
+			index_buffer->resize(mesh.indices.size() * sizeof(unsigned int));
+
+			if (!mesh.indices.empty())
+			{
+				packed_buffer->write(mesh.vertices.data(), mesh.vertices.size(), 0);
+				index_buffer->update(mesh.indices.data());
+			}
+
+			format = mesh.format;
+			lattice = mesh.lattice;
+			uploaded_bytes = mesh.vertices.size() + mesh.indices.size() * sizeof(unsigned int);
+		}
+
+		/**
+		 * Uploads instances built by pack_instances, replacing the current contents.
+		 *
+		 * @remarks Must be called on the thread owning the GL context.
+		 */
+		void upload(const instance_mesh &mesh)
+		{
+			create_buffers();
+
+			const size_t bytes = mesh.instances.size() * sizeof(voxel_instance);
+
+			instance_buffer->resize(bytes);
+
+			if (bytes != 0)
+			{
+				instance_buffer->write(mesh.instances.data(), bytes, 0);
+			}
+
+			format = vertex_format::instanced;
+			lattice = mesh.lattice;
+			instance_count = mesh.instances.size();
+			uploaded_bytes = bytes;
+		}
+
+		[[nodiscard]] vertex_format get_format() const
+		{
+			return format;
+		}
+
+		/**
+		 * Returns the transform from the uploaded vertices to world space.
+		 *
+		 * @remarks Identity for the full format; compact formats store lattice coordinates.
+		 */
+		[[nodiscard]] glm::mat4 get_model_matrix() const
+		{
+			return format == vertex_format::full ? glm::mat4(1.0f) : lattice.model_matrix();
+		}
+
+		[[nodiscard]] size_t get_uploaded_bytes() const
+		{
+			return uploaded_bytes;
+		}
+
+		void update_buffers(voxel_set data)
+		{
+			upload(build_mesh(data));
+		}
+
+		/**
+		 * Frees the GL buffers; the next upload creates them again.
+		 */
+		void destroy_buffers()
+		{
+			delete vertex_buffer;
+			delete color_buffer;
+			delete index_buffer;
+			delete packed_buffer;
+			delete instance_buffer;
+			delete cube_vertex_buffer;
+			delete cube_index_buffer;
+
+			vertex_buffer = nullptr;
+			color_buffer = nullptr;
+			index_buffer = nullptr;
+			packed_buffer = nullptr;
+			instance_buffer = nullptr;
+			cube_vertex_buffer = nullptr;
+			cube_index_buffer = nullptr;
+			instance_count = 0;
+		}
+
+		void draw()
+		{
+			if (format == vertex_format::instanced)
+			{
+				draw_instanced();
+				return;
+			}
+
+			if (format != vertex_format::full)
+			{
+				draw_packed();
+				return;
+			}
+
+			if (vertex_buffer && vertex_buffer->get_size() != 0)
+			{
+				vertex_buffer->bind_vertex(0, 3);
+				color_buffer->bind_vertex(1, 3);
+				index_buffer->bind_indices();
+
+				gfx::draw_elements(index_buffer->get_size());
+				gfx::draw_arrays(0, vertex_buffer->get_size());
+			}
+		}
+
+private:
+		/**
+		 * Fits one lattice over every cube corner of a voxel set.
+		 *
+		 * @param max_coord  The largest coordinate the target format can store.
+		 * @return A lattice of half the smallest voxel size, stretched if the set spans more than max_coord steps.
+		 */
+		static quantization fit_lattice(const voxel_set &data, float max_coord)
+		{
+			glm::vec3 low(std::numeric_limits<float>::max());
+			glm::vec3 high(std::numeric_limits<float>::lowest());
+			float step = std::numeric_limits<float>::max();
+
+			for (const auto &voxel : data)
+			{
+				low = glm::min(low, voxel.position - voxel.size / 2);
+				high = glm::max(high, voxel.position + voxel.size / 2);
+				step = std::min(step, voxel.size / 2);
+			}
+
+			glm::vec3 extent = high - low;
+			float largest = std::max(extent.x, std::max(extent.y, extent.z));
+
+			quantization lattice;
+			lattice.origin = low;
+			lattice.scale = largest / step > max_coord ? largest / max_coord : step;
+
+			return lattice;
+		}
+
+		void draw_instanced()
+		{
+			if (!instance_buffer || instance_count == 0)
+			{
+				return;
+			}
+
+			const vertex_attribute attributes[] = {
+				{ 1, 4, GL_UNSIGNED_SHORT, false, offsetof(voxel_instance, position) },
+				{ 2, 4, GL_UNSIGNED_BYTE, true, offsetof(voxel_instance, color) },
+			};
+
+			cube_vertex_buffer->bind_vertex(0, 3);
+			bind_attributes(instance_buffer, static_cast<GLsizei>(sizeof(voxel_instance)), attributes, 1);
+
+			cube_index_buffer->bind_indices();
+			draw_elements_instanced(cube_vertex_count, instance_count);
+
+			// the other formats read attribute 1 per vertex and never read attribute 2
+			unbind_attributes(attributes);
+		}
+
+		void draw_packed()
+		{
+			if (!packed_buffer || packed_buffer->get_size() == 0)
+			{
+				return;
+			}
+
+			const vertex_attribute position = format == vertex_format::compact_16
+				? vertex_attribute { 0, 3, GL_UNSIGNED_SHORT, false, 0 }
+				: vertex_attribute { 0, 4, GL_UNSIGNED_INT_2_10_10_10_REV, false, 0 };
+
+			const vertex_attribute attributes[] = {
+				position,
+				{ 1, 4, GL_UNSIGNED_BYTE, true, color_offset(format) },
+			};
+
+			bind_attributes(packed_buffer, static_cast<GLsizei>(vertex_stride(format)), attributes);
+
+			index_buffer->bind_indices();
+			gfx::draw_elements(index_buffer->get_size());
+
+			// the full format reads both locations as floats again
+			unbind_attributes(attributes);
+		}
+	};
+
+	/**
+	 * The read-only queries over an octree, shared by the svo being edited and the snapshots read from it.
+	 *
+	 * @remarks Every query walks down from the root. None of them follow parent links or
+	 *          use the index, because those belong to the svo's latest edit, and subtrees
+	 *          shared with older versions may point anywhere. A view of a destroyed or
+	 *          moved-from svo has no root, and every query on it finds nothing.
+	 */
+	class octree_view
+	{
+public:
+		// distance hints count in fractions of a cell and saturate at a few cells,
+		// which bounds the neighbourhood an edit has to rescan
+		constexpr static int distance_hint_steps = 8;
+		constexpr static int max_distance_hint = 4 * distance_hint_steps;
+
+		node *root;
+
+		explicit octree_view(node *root = nullptr)
+				: root(root)
+		{
+		}
+
+		/**
+		 * Maps a point to the lattice cell containing it on a level.
+		 *
+		 * @remarks Children sit a full child size from their parent's center, so a node's
+		 *          cell on the lattice is twice its voxel's size and every level's cells
+		 *          tile the root's subtree bounds exactly.
+		 */
+		[[nodiscard]] glm::ivec3 lattice_coord(const glm::vec3 &point, int level) const
+		{
+			if (!root)
+			{
+				// outside every level's lattice
+				return glm::ivec3(-1);
+			}
+
+			const auto &bounds = root->voxels[0];
+			glm::vec3 scaled = ((point - bounds.position) / bounds.size + 1.0f) * static_cast<float>(1 << level) * 0.5f;
+
+			return glm::ivec3(glm::floor(scaled));
+		}
+
+		/**
+		 * Looks up the node at a lattice coordinate by walking down from the root.
+		 *
+		 * @remarks Equivalent to find, kept as the reference the hashed index is checked
+		 *          and benchmarked against.
+		 */
+		[[nodiscard]] node *descend(int level, const glm::ivec3 &coord) const
+		{
+			if (level < 0 || level > morton::max_level || !in_lattice(level, coord))
+			{
+				return nullptr;
+			}
+
+			node *current = root;
+
+			for (int shift = level - 1; current && shift >= 0; shift--)
+			{
+				glm::ivec3 bit = (coord >> shift) & 1;
+				current = current->children[bit.x | bit.y << 1 | bit.z << 2];
+			}
+
+			return current;
+		}
+
+		/**
+		 * Marches a ray through the lattice to the first occupied voxel it hits.
+		 *
+		 * @param ray           The ray to march; left unchanged.
+		 * @param max_distance  The maximum distance to march, in units of the ray's direction.
+		 * @param use_hints     Whether empty cells may be skipped using their distance hints.
+		 * @return The nearest hit, and the number of steps it took.
+		 *
+		 * @remarks Each step descends from the root to the cell containing the current point.
+		 *          No voxel lies within an empty cell's distance hint of it, so the ray jumps
+		 *          straight to where it leaves the cell grown by the hint, instead of crossing
+		 *          the empty space around it one cell at a time.
+		 */
+		march_result march(ray::raycast &ray, float max_distance, bool use_hints = true) const
+		{
+			march_result result;
+			result.distance = std::numeric_limits<float>::max();
+			result.node = nullptr;
+
+			if (!root)
+			{
+				return result;
+			}
+
+			const glm::vec3 origin = ray.get_origin();
+			const glm::vec3 direction = ray.get_direction();
+			glm::vec3 inverse_direction;
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				inverse_direction[axis] = direction[axis] != 0.0f ? 1.0f / direction[axis] : std::numeric_limits<float>::max();
+			}
+
+			glm::vec2 span = ray_box(subtree_bounds(root), origin, inverse_direction);
+
+			if (span.x > span.y || span.y < 0.0f)
+			{
+				return result;
+			}
+
+			// moves the ray just past a cell boundary so the next lookup lands in the following cell
+			const float nudge = root->voxels[0].size * 1e-5f;
+			const float end = std::min(span.y, max_distance);
+
+			float t = std::max(span.x, 0.0f);
+
+			while (t <= end && result.steps < max_march_steps)
+			{
+				result.steps++;
+
+				const glm::vec3 point = origin + direction * t;
+				const node *current = root;
+				collision::aabb empty;
+
+				while (true)
+				{
+					if (current->brick)
+					{
+						if (march_brick(ray, current, t, max_distance, result))
+						{
+							return result;
+						}
+
+						empty = cell_bounds(current->depth, current->coord);
+						break;
+					}
+
+					if (current->is_leaf())
+					{
+						for (const auto &voxel : current->voxels)
+						{
+							if (voxel.size > 0.0f)
+							{
+								float hit = ray.intersect_cube(voxel.position, voxel.size);
+
+								if (hit >= 0.0f && hit <= max_distance && hit < result.distance)
+								{
+									result.distance = hit;
+									result.hit = true;
+									result.node = const_cast<node *>(current);
+									result.voxel = voxel;
+								}
+							}
+						}
+
+						if (result.hit)
+						{
+							return result;
+						}
+
+						// voxels don't fill their cells, so a leaf can still be passed by
+						empty = cell_bounds(current->depth, current->coord);
+						break;
+					}
+
+					const glm::ivec3 base = current->coord * 2;
+					const glm::ivec3 coord = glm::clamp(lattice_coord(point, current->depth + 1), base, base + 1);
+					const glm::ivec3 bit = coord - base;
+					const int slot = bit.x | bit.y << 1 | bit.z << 2;
+
+					const node *child = current->children[slot];
+
+					if (child && child->coverage > 0.0f)
+					{
+						current = child;
+						continue;
+					}
+
+					float reach = use_hints ? static_cast<float>(current->child_distance[slot]) / distance_hint_steps : 0.0f;
+					empty = cell_bounds(current->depth + 1, coord, reach);
+					break;
+				}
+
+				t = std::max(t, ray_box(empty, origin, inverse_direction).y) + nudge;
+			}
+
+			return result;
+		}
+
+		/**
+		 * Performs ray marching recursively through the octree to find the distance to the nearest surface.
+		 *
+		 * @param ray           The ray to march.
+		 * @param max_distance  The maximum distance to march.
+		 * @param node          The current node being processed.
+		 * @return The distance to the nearest surface.
+		 *
+		 * @remarks This function performs ray marching recursively
+		 *          through the octree to find the distance to the nearest surface.
+		 */
+		march_result march_recursive(ray::raycast &ray, float max_distance, node *node) const
+		{
+			march_result result;
+			result.distance = std::numeric_limits<float>::max();
+			result.node = nullptr;
+
+			if (!node)
+			{
+				return result;
+			}
+
+			if (!node->children[0]) // check if the node is a leaf node
+			{
+				for_each_voxel(node, [&](const voxel &voxel) {
+					float t = ray.intersect_cube(voxel.position, voxel.size);
+					if (t >= 0.0f && t < result.distance)
+					{
+						result.distance = t;
+						result.hit = true;
+						result.node = node;
+						result.voxel = voxel;
+					}
+				});
+			}
+			else
+			{
+				for (int i = 0; i < 8; i++)
+				{
+					const auto child = node->children[i];
+
+					// empty subtrees can't produce a hit, so skip the slab test entirely
+					if (child && child->coverage > 0.0f)
+					{
+						float t = ray.intersect_cube(child->voxels[0].position, child->voxels[0].size);
+
+						if (t >= 0.0f && t < result.distance)
+						{
+							ray.set_origin(ray.get_origin() + ray.get_direction() * t);
+
+							march_result child_result = march_recursive(ray, max_distance - t, child);
+
+							if (child_result.node != nullptr && child_result.distance < max_distance)
+							{
+								result.distance = t + child_result.distance;
+								result.hit = true;
+								result.node = child_result.node;
+								result.voxel = child_result.voxel;
+								break;
+							}
+						}
+					}
+				}
+			}
+
+			return result;
+		}
+
+		/**
+		 * Returns the box bounding a node together with all of its descendants.
+		 *
+		 * @param node  The node to bound.
+		 *
+		 * @remarks Children are placed a full child size away from their parent's center,
+		 *          so descendants reach up to one full node size out from it rather than half.
+		 */
+		[[nodiscard]] static collision::aabb subtree_bounds(const node *node)
+		{
+			return collision::aabb::from_center(node->voxels[0].position, glm::vec3(node->voxels[0].size));
+		}
+
+		/**
+		 * Checks whether any occupied voxel overlaps a box.
+		 *
+		 * @param box  The box to test.
+		 * @return The first leaf found overlapping the box, or nullptr.
+		 */
+		node *overlap(const collision::aabb &box) const
+		{
+			return root ? overlap_recursive(root, box, nullptr) : nullptr;
+		}
+
+		/**
+		 * Collects every leaf with an occupied voxel overlapping a box.
+		 *
+		 * @param box    The box to test.
+		 * @param nodes  The set the overlapping leaves are appended to.
+		 */
+		void overlap_all(const collision::aabb &box, std::vector<node *> &nodes) const
+		{
+			if (root)
+			{
+				overlap_recursive(root, box, &nodes);
+			}
+		}
+
+		/**
+		 * Finds the first occupied voxel hit by a box moving along a velocity.
+		 *
+		 * @param box       The box at the start of the move.
+		 * @param velocity  The full displacement of the box.
+		 * @return The time of impact and the contact normal, if anything was hit.
+		 *
+		 * @remarks Subtrees whose bounds the box cannot reach before the best hit found
+		 *          so far are skipped entirely. Voxels the box already overlaps are ignored,
+		 *          so a body that ended up inside the geometry can still move out of it.
+		 */
+		collision_result sweep(const collision::aabb &box, const glm::vec3 &velocity) const
+		{
+			collision_result result;
+
+			if (!root)
+			{
+				return result;
+			}
+
+			auto contact = collision::sweep(box, velocity, subtree_bounds(root));
+
+			if (contact.hit)
+			{
+				sweep_recursive(root, box, velocity, result);
+			}
+
+			return result;
+		}
+
+		/**
+		 * Finds the nearest occupied voxel to a point.
+		 *
+		 * @param point   The point to search from.
+		 * @param radius  The maximum distance to search.
+		 * @return The nearest voxel and its distance to the point, which is zero if the point lies inside it.
+		 */
+		nearest_result nearest(const glm::vec3 &point, float radius) const
+		{
+			nearest_result result;
+			float best_distance_squared = radius * radius;
+
+			if (!root)
+			{
+				return result;
+			}
+
+			nearest_recursive(root, point, best_distance_squared, result);
+
+			if (result.hit)
+			{
+				result.distance = std::sqrt(best_distance_squared);
+			}
+
+			return result;
+		}
+
+		/**
+		 * Runs overlap queries for many boxes within a time budget.
+		 *
+		 * @param boxes    The boxes to test.
+		 * @param results  Receives the first overlapping leaf for each box, index-aligned with `boxes`.
+		 * @param budget   The time after which no further queries are started.
+		 * @return The number of queries completed; results past it are left untouched.
+		 */
+		std::size_t overlap_batch(std::span<const collision::aabb> boxes, std::span<node *> results, std::chrono::microseconds budget) const
+		{
+			return run_batch(boxes.size(), budget, [&](std::size_t i) { results[i] = overlap(boxes[i]); });
+		}
+
+		/**
+		 * Runs swept box queries for many bodies within a time budget.
+		 *
+		 * @param queries  The boxes and velocities to sweep, e.g. gathered from an EnTT view.
+		 * @param results  Receives one result per query, index-aligned with `queries`.
+		 * @param budget   The time after which no further queries are started.
+		 * @return The number of queries completed; results past it are left untouched.
+		 */
+		std::size_t sweep_batch(std::span<const sweep_query> queries, std::span<collision_result> results, std::chrono::microseconds budget) const
+		{
+			return run_batch(queries.size(), budget, [&](std::size_t i) { results[i] = sweep(queries[i].box, queries[i].velocity); });
+		}
+
+		/**
+		 * Runs nearest voxel queries for many points within a time budget.
+		 *
+		 * @param points   The points to search from.
+		 * @param radius   The maximum distance to search from each point.
+		 * @param results  Receives one result per point, index-aligned with `points`.
+		 * @param budget   The time after which no further queries are started.
+		 * @return The number of queries completed; results past it are left untouched.
+		 */
+		std::size_t nearest_batch(std::span<const glm::vec3> points, float radius, std::span<nearest_result> results, std::chrono::microseconds budget) const
+		{
+			return run_batch(points.size(), budget, [&](std::size_t i) { results[i] = nearest(points[i], radius); });
+		}
+
+		int count_voxels(const node *node) const
+		{
+			if (!node)
+			{
+				return 0;
+			}
+
+			int count = 1;
+
+			for (int i = 0; i < 8; i++)
+			{
+				count += count_voxels(node->children[i]);
+			}
+
+			return count;
+		}
+
+		/**
+		 * Marks a node visible, together with its ancestors and its descendants down to a depth.
+		 *
+		 * @remarks Ancestors are found by their lattice coordinates rather than parent links,
+		 *          so this works on snapshots too.
+		 */
+		void mark(const node *node, int depth, visibility_set &visible) const
+		{
+			if (!node)
+			{
+				return;
+			}
+
+			for (int level = 0; level < node->depth; level++)
+			{
+				visible.insert(morton::key(level, node->coord >> (node->depth - level)));
+			}
+
+			mark_subtree(node, depth, visible);
+		}
+
+		std::vector<voxel> get_voxels(const visibility_set &visible) const
+		{
+			voxel_set set;
+			get_voxels_with_depth(root, visible, 1, set);
+			return set;
+		}
+
+		/**
+		 * Collects the voxels of the visible nodes a number of levels below a node.
+		 *
+		 * @remarks Nodes at the last level stand in for their subtrees with an averaged voxel.
+		 *          A brick leaf holds the two levels below it, and gives voxels of whichever of
+		 *          them the depth reaches. Brick colors are quantized to RGBA8, so voxels taken
+		 *          from a brick are within half an 8-bit step of the colors they were given.
+		 */
+		void get_voxels_with_depth(const node *node, const visibility_set &visible, int depth, voxel_set &voxels) const
+		{
+			if (!node || node->coverage <= 0.0f || !visible.contains(node->key()))
+			{
+				return;
+			}
+
+			if (node->brick && depth > 2)
+			{
+				for_each_voxel(node, [&](const voxel &voxel) { voxels.push_back(voxel); });
+				return;
+			}
+
+			if (node->brick && depth == 2)
+			{
+				// one level down is halfway into the brick, where each child's eight brick voxels are averaged
+				for (int i = 0; i < 8; i++)
+				{
+					voxel averaged;
+
+					if (brick_octant_voxel(node, i, averaged))
+					{
+						voxels.push_back(averaged);
+					}
+				}
+
+				return;
+			}
+
+			if (depth <= 1)
+			{
+				if (!node->is_leaf() || node->brick)
+				{
+					// a coarse level stands in for its subtree with the subtree's averaged color
+					voxels.push_back(voxel { node->voxels[0].position, node->average_color, node->voxels[0].size });
+					return;
+				}
+
+				for (int i = 0; i < 8; i += 1)
+				{
+					if (node->voxels[i].size > 0.0f)
+					{
+						voxels.push_back(node->voxels[i]);
+					}
+				}
+			}
+			else if (depth > 1)
+			{
+				for (int i = 0; i < 8; i++)
+				{
+					get_voxels_with_depth(node->children[i], visible, depth - 1, voxels);
+				}
+			}
+		}
+
+protected:
+		/**
+		 * Returns a voxel of a brick leaf, placed where the two levels of nodes it replaced had it.
+		 */
+		[[nodiscard]] static voxel brick_voxel(const node *node, int bit)
+		{
+			const voxel &bounds = node->voxels[0];
+
+			// a node's cell is twice its voxel's size, so the brick's four cells are each half of it
+			float cell = bounds.size * 0.5f;
+			glm::vec3 center = bounds.position - bounds.size + (glm::vec3(voxel_brick::coord(bit)) + 0.5f) * cell;
+
+			return voxel { center, node->brick->color(bit), cell * 0.5f };
+		}
+
+		/**
+		 * Averages the brick voxels in one octant of a brick leaf into the voxel of the child node they replaced.
+		 *
+		 * @param octant    The child slot, x in bit 0, y in bit 1 and z in bit 2.
+		 * @param averaged  Receives the child's voxel.
+		 * @return False if none of the octant's brick voxels are occupied.
+		 */
+		[[nodiscard]] static bool brick_octant_voxel(const node *node, int octant, voxel &averaged)
+		{
+			const voxel &bounds = node->voxels[0];
+			const glm::ivec3 offset(octant & 1, (octant >> 1) & 1, (octant >> 2) & 1);
+
+			glm::vec3 color(0.0f);
+			int count = 0;
+
+			for (int i = 0; i < 8; i++)
+			{
+				const int bit = voxel_brick::bit(offset * 2 + glm::ivec3(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+
+				if (node->brick->contains(bit))
+				{
+					color += node->brick->color(bit);
+					count++;
+				}
+			}
+
+			if (count == 0)
+			{
+				return false;
+			}
+
+			// a node's cell is twice its voxel's size, so each child's cell is one voxel size wide
+			glm::vec3 center = bounds.position - bounds.size + (glm::vec3(offset) + 0.5f) * bounds.size;
+
+			averaged = voxel { center, color / static_cast<float>(count), bounds.size * 0.5f };
+			return true;
+		}
+
+		/**
+		 * Calls a function with each occupied voxel of a leaf, whether it keeps them in voxels or in a brick.
+		 */
+		template<typename Visit>
+		static void for_each_voxel(const node *node, Visit &&visit)
+		{
+			if (node->brick)
+			{
+				for (std::uint64_t bits = node->brick->occupancy; bits; bits &= bits - 1)
+				{
+					visit(brick_voxel(node, std::countr_zero(bits)));
+				}
+
+				return;
+			}
+
+			for (const auto &voxel : node->voxels)
+			{
+				if (voxel.size > 0.0f)
+				{
+					visit(voxel);
+				}
+			}
+		}
+
+		/**
+		 * Returns the cell of a lattice coordinate, grown by a number of cells on every side.
+		 */
+		[[nodiscard]] collision::aabb cell_bounds(int level, const glm::ivec3 &coord, float grow = 0.0f) const
+		{
+			const auto &bounds = root->voxels[0];
+			float cell = 2.0f * bounds.size / static_cast<float>(1 << level);
+
+			glm::vec3 low = bounds.position - bounds.size + (glm::vec3(coord) - grow) * cell;
+			return collision::aabb { low, low + cell * (1.0f + 2.0f * grow) };
+		}
+
+		/**
+		 * Returns the distances along a ray at which it enters and leaves a box.
+		 */
+		[[nodiscard]] static glm::vec2 ray_box(const collision::aabb &box, const glm::vec3 &origin, const glm::vec3 &inverse_direction)
+		{
+			glm::vec3 near = (box.min - origin) * inverse_direction;
+			glm::vec3 far = (box.max - origin) * inverse_direction;
+
+			glm::vec3 enter = glm::min(near, far);
+			glm::vec3 exit = glm::max(near, far);
+
+			return glm::vec2(std::max({ enter.x, enter.y, enter.z }), std::min({ exit.x, exit.y, exit.z }));
+		}
+
+		[[nodiscard]] static bool in_lattice(int level, const glm::ivec3 &coord)
+		{
+			int extent = 1 << level;
+
+			return coord.x >= 0 && coord.y >= 0 && coord.z >= 0
+					&& coord.x < extent && coord.y < extent && coord.z < extent;
+		}
+
+		int max_march_steps = 4096;
+
+private:
+		/**
+		 * Steps a ray through the voxels of a brick leaf, starting where it entered the leaf's cell.
+		 *
+		 * @return Whether a voxel was hit; the hit is written to `result`.
+		 *
+		 * @remarks A 3D DDA over the brick's cells, except that the empty part of the row the
+		 *          ray is in is crossed in one go: the row's bits ahead of the ray are scanned
+		 *          for the next occupied voxel, and the ray moves along x straight to it or to
+		 *          where it turns out of the row.
+		 */
+		bool march_brick(const ray::raycast &ray, const node *node, float t, float max_distance, march_result &result) const
+		{
+			const voxel_brick &brick = *node->brick;
+			const collision::aabb bounds = cell_bounds(node->depth, node->coord);
+
+			const float cell = (bounds.max.x - bounds.min.x) / voxel_brick::extent;
+			const int last = voxel_brick::extent - 1;
+
+			const glm::vec3 origin = ray.get_origin();
+			const glm::vec3 direction = ray.get_direction();
+
+			glm::ivec3 current = glm::clamp(glm::ivec3(glm::floor((origin + direction * t - bounds.min) / cell)), glm::ivec3(0), glm::ivec3(last));
+			glm::ivec3 step;
+			glm::vec3 next_t, delta_t;
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				if (direction[axis] > 0.0f)
+				{
+					step[axis] = 1;
+					next_t[axis] = (bounds.min[axis] + (current[axis] + 1) * cell - origin[axis]) / direction[axis];
+					delta_t[axis] = cell / direction[axis];
+				}
+				else if (direction[axis] < 0.0f)
+				{
+					step[axis] = -1;
+					next_t[axis] = (bounds.min[axis] + current[axis] * cell - origin[axis]) / direction[axis];
+					delta_t[axis] = -cell / direction[axis];
+				}
+				else
+				{
+					step[axis] = 0;
+					next_t[axis] = std::numeric_limits<float>::infinity();
+					delta_t[axis] = std::numeric_limits<float>::infinity();
+				}
+			}
+
+			while (true)
+			{
+				result.steps++;
+
+				const std::uint32_t row = (brick.occupancy >> voxel_brick::bit(glm::ivec3(0, current.y, current.z))) & 0xf;
+
+				// occupied cells of this row from the current one onwards, in the ray's x direction
+				std::uint32_t ahead = row & (1u << current.x);
+
+				if (step.x > 0)
+				{
+					ahead = row & (0xfu << current.x);
+				}
+				else if (step.x < 0)
+				{
+					ahead = row & (0xfu >> (last - current.x));
+				}
+
+				if (ahead & (1u << current.x))
+				{
+					voxel voxel = brick_voxel(node, voxel_brick::bit(current));
+					float hit = ray.intersect_cube(voxel.position, voxel.size);
+
+					if (hit >= 0.0f && hit <= max_distance)
+					{
+						result.distance = hit;
+						result.hit = true;
+						result.node = const_cast<class node *>(node);
+						result.voxel = voxel;
+
+						return true;
+					}
+				}
+				else
+				{
+					int target = step.x > 0 ? voxel_brick::extent : -1;
+
+					if (ahead != 0)
+					{
+						target = step.x > 0 ? std::countr_zero(ahead) : 31 - std::countl_zero(ahead);
+					}
+
+					float turn = std::min(next_t.y, next_t.z);
+
+					while (current.x != target && next_t.x < turn)
+					{
+						current.x += step.x;
+						next_t.x += delta_t.x;
+					}
+
+					if (current.x < 0 || current.x > last)
+					{
+						return false;
+					}
+
+					if (current.x == target)
+					{
+						continue;
+					}
+				}
+
+				int axis = next_t.x < next_t.y ? (next_t.x < next_t.z ? 0 : 2) : (next_t.y < next_t.z ? 1 : 2);
+
+				if (next_t[axis] > max_distance)
+				{
+					return false;
+				}
+
+				current[axis] += step[axis];
+				next_t[axis] += delta_t[axis];
+
+				if (current[axis] < 0 || current[axis] > last)
+				{
+					return false;
+				}
+			}
+		}
+
+		node *overlap_recursive(node *node, const collision::aabb &box, std::vector<class node *> *nodes) const
+		{
+			if (!subtree_bounds(node).overlaps(box))
+			{
+				return nullptr;
+			}
+
+			if (node->is_leaf())
+			{
+				bool overlapping = false;
+
+				for_each_voxel(node, [&](const voxel &voxel) {
+					overlapping = overlapping || collision::aabb::from_cube(voxel.position, voxel.size).overlaps(box);
+				});
+
+				if (overlapping && nodes)
+				{
+					nodes->push_back(node);
+				}
+
+				return overlapping ? node : nullptr;
+			}
+
+			class node *found = nullptr;
+
+			for (auto child : node->children)
+			{
+				if (child)
+				{
+					if (auto hit = overlap_recursive(child, box, nodes))
+					{
+						found = hit;
+
+						if (!nodes)
+						{
+							break;
+						}
+					}
+				}
+			}
+
+			return found;
+		}
+
+		void sweep_recursive(node *node, const collision::aabb &box, const glm::vec3 &velocity, collision_result &result) const
+		{
+			if (node->is_leaf())
+			{
+				for_each_voxel(node, [&](const voxel &voxel) {
+					auto contact = collision::sweep(box, velocity, collision::aabb::from_cube(voxel.position, voxel.size));
+
+					if (contact.hit && !contact.started_inside && contact.time < result.time)
+					{
+						result.hit = true;
+						result.time = contact.time;
+						result.normal = contact.normal;
+						result.node = node;
+						result.voxel = voxel;
+					}
+				});
+
+				return;
+			}
+
+			// visit children in the order the box reaches them, so the nearest hit prunes the rest early
+			std::pair<float, class node *> order[8];
+			int count = 0;
+
+			for (auto child : node->children)
+			{
+				if (child)
+				{
+					auto contact = collision::sweep(box, velocity, subtree_bounds(child));
+
+					if (contact.hit)
+					{
+						order[count++] = { contact.time, child };
+					}
+				}
+			}
+
+			std::sort(order, order + count, [](const auto &a, const auto &b) { return a.first < b.first; });
+
+			for (int i = 0; i < count && order[i].first < result.time; i++)
+			{
+				sweep_recursive(order[i].second, box, velocity, result);
+			}
+		}
+
+		void nearest_recursive(node *node, const glm::vec3 &point, float &best_distance_squared, nearest_result &result) const
+		{
+			if (node->is_leaf())
+			{
+				for_each_voxel(node, [&](const voxel &voxel) {
+					float distance_squared = collision::aabb::from_cube(voxel.position, voxel.size).distance_squared(point);
+
+					if (distance_squared <= best_distance_squared)
+					{
+						best_distance_squared = distance_squared;
+						result.hit = true;
+						result.node = node;
+						result.voxel = voxel;
+					}
+				});
+
+				return;
+			}
+
+			std::pair<float, class node *> order[8];
+			int count = 0;
+
+			for (auto child : node->children)
+			{
+				if (child)
+				{
+					float distance_squared = subtree_bounds(child).distance_squared(point);
+
+					if (distance_squared <= best_distance_squared)
+					{
+						order[count++] = { distance_squared, child };
+					}
+				}
+			}
+
+			std::sort(order, order + count, [](const auto &a, const auto &b) { return a.first < b.first; });
+
+			for (int i = 0; i < count && order[i].first <= best_distance_squared; i++)
+			{
+				nearest_recursive(order[i].second, point, best_distance_squared, result);
+			}
+		}
+
+		static void mark_subtree(const node *node, int depth, visibility_set &visible)
+		{
+			visible.insert(node->key());
+
+			if (depth != 0)
+			{
+				for (const class node *child : node->children)
+				{
+					if (child)
+					{
+						mark_subtree(child, depth - 1, visible);
+					}
+				}
+			}
+		}
+
+		template<typename Query>
+		std::size_t run_batch(std::size_t count, std::chrono::microseconds budget, Query &&query) const
+		{
+			const auto deadline = std::chrono::steady_clock::now() + budget;
+			std::size_t completed = 0;
+
+			while (completed < count && std::chrono::steady_clock::now() < deadline)
+			{
+				query(completed);
+				completed++;
+			}
+
+			return completed;
+		}
+	};
+
+	/**
+	 * A published version of an svo, pinned for as long as the snapshot exists.
+	 *
+	 * @remarks Edits made after the snapshot was taken never show up in it, and the nodes it
+	 *          reaches are not freed until it is destroyed. Taking and releasing a snapshot
+	 *          never blocks on the editor, but a snapshot kept for a long time keeps every
+	 *          version since it alive, so take one per query or per frame.
+	 */
+	class snapshot : public octree_view
+	{
+public:
+		explicit snapshot(epoch_domain<node> &versions)
+				: versions(versions)
+		{
+			auto pinned = versions.enter();
+
+			slot = pinned.slot;
+			root = const_cast<node *>(pinned.version);
+		}
+
+		~snapshot()
+		{
+			versions.leave(slot);
+		}
+
+		snapshot(const snapshot &) = delete;
+		snapshot &operator=(const snapshot &) = delete;
+
+private:
+		epoch_domain<node> &versions;
+		std::size_t slot;
+	};
+
+	/**
+	 * A sparse voxel octree being edited, which publishes immutable versions for other threads to read.
+	 *
+	 * @remarks A published node is never written to again: editing it copies the node and its
+	 *          ancestors up to the root, and the copies are what find returns and later edits
+	 *          change. Nodes made since the last publish aren't shared yet, so they are edited
+	 *          in place. Replaced nodes are freed by a later publish, once no snapshot can
+	 *          reach them anymore.
+	 */
+	class svo : public octree_view
+	{
+public:
+		/**
+		 * Constructs an SVO with a root voxel.
+		 *
+		 * @param position   The position of the root voxel.
+		 * @param color      The color of the root voxel.
+		 * @param root_size  The size of the root voxel.
+		 *
+		 * @remarks This constructor initializes the SVO with a root voxel at the specified position, color, and size.
+		 *          The root is published straight away, so there is always a version to read.
+		 */
+		svo(const glm::vec3 &position, const glm::vec3 &color, float root_size)
+				: buffer(position)
+				, versions(std::make_unique<epoch_domain<node>>())
+		{
+			root = new node();
+			root->position = position;
+			root->voxels[0] = voxel { position, color, root_size };
+			root->version = editing_version;
+
+			index.insert(root->key(), root);
+			level_nodes[0] = 1;
+			summarize(root);
+
+			publish();
+		}
+
+		// the nodes belong to one svo; a copy would share them and free them twice
+		svo(const svo &) = delete;
+		svo &operator=(const svo &) = delete;
+
+		/**
+		 * Takes over another svo's nodes, buffers and published versions.
+		 *
+		 * @remarks The moved-from svo is left empty, as after destroy, so destroying or
+		 *          reading it again is harmless. No snapshot of it may be held across the move.
+		 */
+		svo(svo &&other)
+				: octree_view(std::exchange(other.root, nullptr))
+				, buffer(std::move(other.buffer))
+		{
+			take(other);
+		}
+
+		svo &operator=(svo &&other)
+		{
+			if (this != &other)
+			{
+				destroy();
+
+				root = std::exchange(other.root, nullptr);
+				buffer = std::move(other.buffer);
+				take(other);
+			}
+
+			return *this;
+		}
+
+		/**
+		 * Subdivides a node into eight children nodes.
+		 *
+		 * @param node  The node to subdivide.
+		 *
+		 * @remarks This function subdivides the specified
+		 *          node into eight children nodes. Any children the node
+		 *          already had are destroyed and replaced, and the distance
+		 *          hints of empty cells around it are brought up to date.
+		 */
+		void subdivide_node(node *node)
+		{
+			node = split_node(node);
+			refresh_path(node);
+
+			// children reach past their parent's voxel, so empty cells nearby may have shrunk
+			refresh_distance_hints_near(root, subtree_bounds(node));
+		}
+
+		/**
+		 * Recomputes the occupancy mask, coverage and average color of a subtree.
+		 *
+		 * @param node             The root of the subtree to reduce.
+		 * @param parallel_levels  How many levels below `node` fan their children out to separate threads.
+		 *
+		 * @remarks Sibling subtrees are disjoint, so they reduce independently before their
+		 *          parent combines them. The ancestors of `node` are refreshed afterwards.
+		 */
+		void reduce_attributes(node *node, int parallel_levels = 1)
+		{
+			// copying is done up front, since the threads below can't all update the index
+			node = unshare_subtree(node);
+
+			reduce_subtree(node, parallel_levels);
+			refresh_ancestors(node);
+		}
+
+		void reduce_attributes()
+		{
+			reduce_attributes(root);
+		}
+
+		/**
+		 * Recolors a leaf and refreshes the averaged colors along its ancestor path.
+		 */
+		void set_color(node *node, const glm::vec3 &color)
+		{
+			node = writable(node);
+			node->voxels[0].color = color;
+
+			refresh_path(node);
+		}
+
+		/**
+		 * Removes a node and its whole subtree from the octree.
+		 *
+		 * @param node     The node to remove, or a published version of it that copy-on-write
+		 *                 has since replaced; the root cannot be removed.
+		 * @param refresh  Whether to refresh the ancestors' attributes and the emptied slot's
+		 *                 hint. Bulk edits pass false and call reduce_attributes and
+		 *                 compute_distance_hints once when they are done.
+		 *
+		 * @remarks A parent left without children is removed as well, since a
+		 *          childless node would otherwise read as one solid leaf. The emptied
+		 *          slot gets a distance hint; hints elsewhere stay conservative.
+		 */
+		void remove_node(node *node, bool refresh = true)
+		{
+			if (!node)
+			{
+				return;
+			}
+
+			// the caller's node may be stale: copy-on-write may have replaced it since it was found,
+			// or an earlier removal taken it out, so it is looked up again before its parent is touched
+			class node *current = index.find(node->key());
+
+			if (!current || !current->parent)
+			{
+				return;
+			}
+
+			class node *parent = writable(current->parent);
+			const int slot = current->slot();
+
+			if (parent->children[slot] != current)
+			{
+				return;
+			}
+
+			const int level = current->depth;
+			const glm::ivec3 coord = current->coord;
+
+			parent->children[slot] = nullptr;
+
+			retire_subtree(current);
+
+			if (parent->parent && parent->is_leaf())
+			{
+				remove_node(parent, refresh);
+			}
+			else if (refresh)
+			{
+				refresh_path(parent);
+
+				// hints around the hole can only have grown, so only the hole itself needs one
+				refresh_distance_hint(level, coord);
+			}
+		}
+
+		/**
+		 * Looks up the node at a lattice coordinate through the hashed index.
+		 *
+		 * @param level  The depth of the node below the root.
+		 * @param coord  The node's coordinate on that level's lattice, each axis in [0, 2^level).
+		 * @return The node, or nullptr if that cell was never subdivided into or has been removed.
+		 */
+		[[nodiscard]] node *find(int level, const glm::ivec3 &coord) const
+		{
+			if (level < 0 || level > morton::max_level || !in_lattice(level, coord))
+			{
+				return nullptr;
+			}
+
+			return index.find(morton::key(level, coord));
+		}
+
+		/**
+		 * Finds the node sharing a face with another node.
+		 *
+		 * @param node  The node to start from.
+		 * @param face  The face to step across.
+		 * @return The neighbour on the same level or, where that cell was never subdivided
+		 *         into, the coarser leaf covering it; nullptr if the cell is empty or
+		 *         outside the octree.
+		 */
+		[[nodiscard]] node *neighbor(const node *node, face face) const
+		{
+			glm::ivec3 coord = node->coord;
+			int axis = static_cast<int>(face) / 2;
+
+			coord[axis] += (static_cast<int>(face) & 1) ? 1 : -1;
+
+			if (!in_lattice(node->depth, coord))
+			{
+				return nullptr;
+			}
+
+			if (class node *found = index.find(morton::key(node->depth, coord)))
+			{
+				return found;
+			}
+
+			// a coarser leaf covers the cell; a coarser interior node means the cell was removed
+			for (int level = node->depth - 1; level >= 0; level--)
+			{
+				coord = coord >> 1;
+
+				if (class node *found = index.find(morton::key(level, coord)))
+				{
+					return found->is_leaf() ? found : nullptr;
+				}
+			}
+
+			return nullptr;
+		}
+
+		/**
+		 * Finds the deepest node whose lattice cell contains a point.
+		 *
+		 * @param point  The point to look up.
+		 * @return The node, or nullptr if the point lies outside the octree.
+		 *
+		 * @remarks Every ancestor of an existing node exists too, so the deepest level
+		 *          is found by binary search over levels rather than a walk from the root.
+		 */
+		[[nodiscard]] node *locate(const glm::vec3 &point) const
+		{
+			if (!in_lattice(0, lattice_coord(point, 0)))
+			{
+				return nullptr;
+			}
+
+			node *found = root;
+			int low = 1, high = max_depth;
+
+			while (low <= high)
+			{
+				int level = (low + high) / 2;
+
+				if (node *candidate = index.find(morton::key(level, lattice_coord(point, level))))
+				{
+					found = candidate;
+					low = level + 1;
+				}
+				else
+				{
+					high = level - 1;
+				}
+			}
+
+			return found;
+		}
+
+		void subdivide_recursively(node *node, int recursion_amount)
+		{
+			if (node)
+			{
+				node = split_recursively(node, recursion_amount);
+
+				// small subtrees reduce faster than threads can be started for them
+				reduce_attributes(node, recursion_amount >= min_parallel_reduce_levels ? 1 : 0);
+				refresh_distance_hints_near(root, subtree_bounds(node));
+			}
+		}
+
+		/**
+		 * Constructs the octree recursively by subdividing nodes.
+		 *
+		 * @remarks This function constructs the octree recursively by subdividing nodes
+		 *          until the minimum voxel size is reached.
+		 */
+		void construct_octree()
+		{
+			construct_octree_recursive(root);
+			reduce_attributes();
+		}
+
+		/**
+		 * Constructs the octree recursively by subdividing nodes.
+		 *
+		 * @param node  The current node being processed.
+		 *
+		 * @remarks This function constructs the octree recursively
+		 *          by subdividing nodes until the minimum voxel size
+		 *          for the sparse voxel octree is reached. Node attributes
+		 *          are left for the caller to reduce afterwards.
+		 */
+		void construct_octree_recursive(node *node)
+		{
+			if (node->voxels[0].size <= min_voxel_size)
+			{
+				return;
+			}
+
+			node = split_node(node);
+
+			for (int i = 0; i < 8; i++)
+			{
+				if (node->children[i])
+				{
+					construct_octree_recursive(node->children[i]);
+				}
+			}
+		}
+
+		/**
+		 * Recomputes the distance hints of every empty child slot in the octree.
+		 *
+		 * @remarks Edits keep the hints conservative on their own; bulk edits that carve
+		 *          out large regions call this afterwards so the hints grow to match.
+		 *          Coverage has to be up to date first.
+		 */
+		void compute_distance_hints()
+		{
+			compute_distance_hints_recursive(root);
+		}
+
+		/**
+		 * Packs every subtree whose leaves all sit exactly two levels down into a single brick leaf.
+		 *
+		 * @return The number of bricks made.
+		 *
+		 * @remarks Voxels keep their positions, sizes and colors, so queries and meshing see
+		 *          the same scene as before. The cells inside a brick no longer have nodes of
+		 *          their own, so find returns nullptr for them; splitting a brick leaf again
+		 *          discards the brick.
+		 */
+		std::size_t build_bricks()
+		{
+			std::size_t made = 0;
+
+			build_bricks_recursive(root, made);
+			reduce_attributes(root, 0);
+
+			// most of the nodes are gone, so the index can be much smaller
+			index.shrink();
+
+			return made;
+		}
+
+		/**
+		 * Returns the bytes held by the nodes, their bricks and the index.
+		 */
+		[[nodiscard]] std::size_t memory_usage() const
+		{
+			return memory_usage_recursive(root) + index.memory_usage();
+		}
+
+		/**
+		 * Pins the latest published version for reading.
+		 *
+		 * @remarks Safe to call from any thread, also while this svo is being edited; the
+		 *          snapshot neither takes nor waits for a lock.
+		 */
+		[[nodiscard]] snapshot read() const
+		{
+			return snapshot(*versions);
+		}
+
+		/**
+		 * Makes the tree as it stands the version new snapshots read.
+		 *
+		 * @return The version's number.
+		 *
+		 * @remarks Every node reachable now is shared from here on, so the next edit to it
+		 *          makes a copy; node pointers held across a publish may then refer to the
+		 *          published node rather than the one being edited, and are freed once it is
+		 *          replaced and no snapshot needs it. Look them up again with find.
+		 */
+		std::uint64_t publish()
+		{
+			const std::uint64_t version = versions->publish(root);
+
+			// what this round replaced is still reachable from every earlier version
+			for (node *node : replaced)
+			{
+				retired.push_back(retired_node { version, node });
+			}
+
+			replaced.clear();
+			editing_version = version + 1;
+
+			reclaim();
+			return version;
+		}
+
+		/**
+		 * Returns how many replaced nodes are waiting for snapshots to let go of them.
+		 */
+		[[nodiscard]] std::size_t retired_count() const
+		{
+			return replaced.size() + retired.size();
+		}
+
+		void flatten_octree(const node *node, std::vector<voxel> &data, int &index)
+		{
+			if (!node)
+			{
+				return;
+			}
+
+			glm::vec3 node_position = root->position + node->position;
+
+			for (int i = 0; i < 8; i++)
+			{
+				data[index].position = node_position + node->voxels[i].position;
+				data[index].color = node->voxels[i].color;
+				data[index].size = node->voxels[i].size;
+				index++;
+			}
+
+			for (int i = 0; i < 8; i++)
+			{
+				flatten_octree(node->children[i], data, index);
+			}
+		}
+
+		void bind_to_gpu(buffer::buffer *buffer)
+		{
+			int numVoxels = count_voxels(root);
+			int current = 0;
+
+			std::vector<voxel> data(numVoxels);
+			flatten_octree(root, data, current);
+
+			buffer->write(data.data(), sizeof(voxel) * numVoxels, 0);
+		}
+
+		void update_buffer(voxel_set data)
+		{
+			this->buffer.update_buffers(data);
+		}
+
+		void draw_buffer()
+		{
+			this->buffer.draw();
+		}
+
+		void upload_mesh(const mesh_data &mesh)
+		{
+			this->buffer.upload(mesh);
+		}
+
+		void upload_mesh(const compact_mesh &mesh)
+		{
+			this->buffer.upload(mesh);
+		}
+
+		void upload_mesh(const instance_mesh &mesh)
+		{
+			this->buffer.upload(mesh);
+		}
+
+		[[nodiscard]] const grid_buffer &get_buffer() const
+		{
+			return this->buffer;
+		}
+
+		/**
+		 * Frees only the GL buffers of this octree, leaving its nodes in place.
+		 *
+		 * @remarks Must be called on the thread owning the GL context.
+		 */
+		void destroy_buffers()
+		{
+			buffer.destroy_buffers();
+		}
+
+		/**
+		 * Frees every node and the GL buffers of this octree.
+		 *
+		 * @remarks This is an explicit call for the owner to make rather than a destructor,
+		 *          so the GL part can run on the thread owning the context. Once
+		 *          destroy_buffers has run there is no GL part left, and any thread can
+		 *          free the nodes. No snapshot may be held while it runs.
+		 */
+		void destroy()
+		{
+			if (root)
+			{
+				free_subtree(root);
+				root = nullptr;
+			}
+
+			index.clear();
+			level_nodes = {};
+			max_depth = 0;
+
+			for (node *node : replaced)
+			{
+				delete node;
+			}
+
+			for (const auto &entry : retired)
+			{
+				delete entry.node;
+			}
+
+			replaced.clear();
+			retired.clear();
+
+			// snapshots taken from now on see an empty tree rather than freed nodes
+			versions->publish(nullptr);
+
+			buffer.destroy_buffers();
+		}
+
+		void draw_node_buffer(glm::vec3 position_from, glm::vec3 direction, int depth, const visibility_set &visible)
+		{
+			voxel_set voxels;
+
+			get_voxels_with_depth(root, visible, depth, voxels);
+
+			if (voxels.size() > 0)
+			{
+				update_buffer(voxels);
+				draw_buffer();
+			}
+		}
+
+		/**
+		 * Collects the occupied leaf voxels that have at least one uncovered face.
+		 *
+		 * @param voxels  The set the exposed voxels are appended to.
+		 *
+		 * @remarks A face counts as covered only when a node exists across it, so
+		 *          voxels on the outside of the octree are always collected.
+		 */
+		void get_surface_voxels(voxel_set &voxels) const
+		{
+			get_surface_voxels_recursive(root, voxels);
+		}
+
+private:
+		/**
+		 * Subdivides a node without refreshing the attributes of it or its ancestors.
+		 *
+		 * @return The node as it now stands in the tree, which is a copy if it had been published.
+		 *
+		 * @remarks Bulk builders use this and reduce the whole subtree once at the end,
+		 *          instead of walking the ancestor path for every node they split.
+		 */
+		node *split_node(node *node)
+		{
+			if (node->depth >= morton::max_level)
+			{
+				return node;
+			}
+
+			node = writable(node);
+			destroy_children(node);
+			node->brick.reset();
+
+			const glm::vec3 &parent_pos = node->voxels[0].position;
+
+			float parent_size = node->voxels[0].size;
+			float child_size = parent_size / 2;
+
+			for (int i = 0; i < 8; i++)
+			{
+				glm::vec3 child_position = parent_pos;
+				glm::vec3 child_color = (node->voxels[0].color * (static_cast<float>(i) / 8));
+
+				child_position.x += (i & 1) ? child_size : -child_size;
+				child_position.y += (i & 2) ? child_size : -child_size;
+				child_position.z += (i & 4) ? child_size : -child_size;
+
+				node->children[i] = new class node();
+				node->children[i]->parent = node;
+				node->children[i]->position = child_position;
+				node->children[i]->voxels[0] = voxel { child_position, child_color, child_size };
+				node->children[i]->depth = node->depth + 1;
+				node->children[i]->coord = node->coord * 2 + glm::ivec3(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+				node->children[i]->version = editing_version;
+
+				index.insert(node->children[i]->key(), node->children[i]);
+				summarize(node->children[i]);
+			}
+
+			level_nodes[node->depth + 1] += 8;
+			max_depth = std::max(max_depth, node->depth + 1);
+
+			return node;
+		}
+
+		node *split_recursively(node *node, int recursion_amount)
+		{
+			if (recursion_amount >= 1 && node)
+			{
+				node = split_node(node);
+
+				for (int i = 0; i < 8; i++)
+				{
+					split_recursively(node->children[i], recursion_amount - 1);
+				}
+			}
+
+			return node;
+		}
+
+		static void reduce_subtree(node *node, int parallel_levels)
+		{
+			if (parallel_levels > 0)
+			{
+				std::vector<std::future<void>> tasks;
+
+				for (auto child : node->children)
+				{
+					if (child)
+					{
+						tasks.push_back(std::async(std::launch::async, [child, parallel_levels] { reduce_subtree(child, parallel_levels - 1); }));
+					}
+				}
+
+				for (auto &task : tasks)
+				{
+					task.get();
+				}
+			}
+			else
+			{
+				for (auto child : node->children)
+				{
+					if (child)
+					{
+						reduce_subtree(child, 0);
+					}
+				}
+			}
+
+			summarize(node);
+		}
+
+		/**
+		 * Computes a node's attributes from its voxels if it is a leaf, or from its children's attributes.
+		 *
+		 * @remarks Coverage is the occupied fraction of the node's volume at leaf resolution,
+		 *          and the average color is weighted by it, so a mostly empty child barely
+		 *          tints its parent.
+		 */
+		static void summarize(node *node)
+		{
+			node->child_mask = 0;
+			node->coverage = 0.0f;
+			node->average_color = glm::vec3(0.0f);
+
+			if (node->brick)
+			{
+				const int occupied = node->brick->count();
+
+				for (std::uint64_t bits = node->brick->occupancy; bits; bits &= bits - 1)
+				{
+					node->average_color += node->brick->color(std::countr_zero(bits));
+				}
+
+				if (occupied > 0)
+				{
+					node->coverage = static_cast<float>(occupied) / voxel_brick::voxel_count;
+					node->average_color /= static_cast<float>(occupied);
+				}
+
+				return;
+			}
+
+			if (node->is_leaf())
+			{
+				int occupied = 0;
+
+				for (const auto &voxel : node->voxels)
+				{
+					if (voxel.size > 0.0f)
+					{
+						node->average_color += voxel.color;
+						occupied++;
+					}
+				}
+
+				if (occupied > 0)
+				{
+					node->coverage = 1.0f;
+					node->average_color /= static_cast<float>(occupied);
+				}
+
+				return;
+			}
+
+			for (int i = 0; i < 8; i++)
+			{
+				const auto child = node->children[i];
+
+				if (child && child->coverage > 0.0f)
+				{
+					node->child_mask |= 1 << i;
+					node->coverage += child->coverage;
+					node->average_color += child->average_color * child->coverage;
+				}
+			}
+
+			if (node->coverage > 0.0f)
+			{
+				node->average_color /= node->coverage;
+				node->coverage /= 8.0f;
+			}
+		}
+
+		void refresh_ancestors(node *node)
+		{
+			for (auto ancestor = node->parent; ancestor; ancestor = ancestor->parent)
+			{
+				ancestor = writable(ancestor);
+				summarize(ancestor);
+			}
+		}
+
+		void refresh_path(node *node)
+		{
+			node = writable(node);
+			summarize(node);
+			refresh_ancestors(node);
+		}
+
+		/**
+		 * Returns a node that can be written to in place of a published one.
+		 *
+		 * @param node  A node of the tree, or one it replaced earlier in this editing round.
+		 * @return The node itself if it hasn't been published, or else its copy.
+		 *
+		 * @remarks A copy has to be reachable from the root, so its parent is made writable
+		 *          first and pointed at it, all the way up. Children keep being shared; only
+		 *          their parent links move over to the copy.
+		 */
+		node *writable(node *node)
+		{
+			if (node->version == editing_version)
+			{
+				return node;
+			}
+
+			class node *current = index.find(node->key());
+
+			if (current && current != node)
+			{
+				return writable(current);
+			}
+
+			class node *copy = new class node(*node);
+			copy->version = editing_version;
+
+			if (node->parent)
+			{
+				copy->parent = writable(node->parent);
+				copy->parent->children[node->slot()] = copy;
+			}
+			else
+			{
+				root = copy;
+			}
+
+			for (auto child : copy->children)
+			{
+				if (child)
+				{
+					child->parent = copy;
+				}
+			}
+
+			index.insert(copy->key(), copy);
+			retire(node);
+
+			return copy;
+		}
+
+		/**
+		 * Makes every node of a subtree writable.
+		 *
+		 * @return The subtree's root as it now stands in the tree.
+		 */
+		node *unshare_subtree(node *node)
+		{
+			node = writable(node);
+
+			for (auto child : node->children)
+			{
+				if (child)
+				{
+					unshare_subtree(child);
+				}
+			}
+
+			return node;
+		}
+
+		/**
+		 * Takes a node out of use; it is freed right away unless a snapshot may reach it.
+		 */
+		void retire(node *node)
+		{
+			if (node->version == editing_version)
+			{
+				delete node;
+				return;
+			}
+
+			replaced.push_back(node);
+		}
+
+		/**
+		 * Retires a node that has been unlinked from its parent, along with its whole subtree.
+		 *
+		 * @remarks Published nodes are left as they are, since snapshots may still walk them.
+		 */
+		void retire_subtree(node *node)
+		{
+			for (auto child : node->children)
+			{
+				if (child)
+				{
+					retire_subtree(child);
+				}
+			}
+
+			index.erase(node->key());
+			level_nodes[node->depth]--;
+
+			// the deepest level may have just emptied, and locate shouldn't keep searching it
+			while (max_depth > 0 && level_nodes[max_depth] == 0)
+			{
+				max_depth--;
+			}
+
+			retire(node);
+		}
+
+		/**
+		 * Retires every descendant of a writable node, leaving it childless.
+		 */
+		void destroy_children(node *node)
+		{
+			for (auto &child : node->children)
+			{
+				if (child)
+				{
+					retire_subtree(child);
+					child = nullptr;
+				}
+			}
+		}
+
+		/**
+		 * Moves everything but the root and buffers over from another svo, leaving it empty.
+		 */
+		void take(svo &other)
+		{
+			min_voxel_size = other.min_voxel_size;
+			max_depth = std::exchange(other.max_depth, 0);
+			level_nodes = std::exchange(other.level_nodes, {});
+			min_parallel_reduce_levels = other.min_parallel_reduce_levels;
+
+			index = std::move(other.index);
+			other.index.clear();
+
+			editing_version = other.editing_version;
+			replaced = std::exchange(other.replaced, {});
+			retired = std::exchange(other.retired, {});
+
+			// the source keeps a domain of its own with nothing published, so read hands out a null root
+			versions = std::exchange(other.versions, std::make_unique<epoch_domain<node>>());
+		}
+
+		static void free_subtree(node *node)
+		{
+			for (auto child : node->children)
+			{
+				if (child)
+				{
+					free_subtree(child);
+				}
+			}
+
+			delete node;
+		}
+
+		/**
+		 * Frees the retired nodes that no snapshot can reach anymore.
+		 */
+		void reclaim()
+		{
+			const std::uint64_t oldest = versions->oldest_read();
+
+			while (!retired.empty() && retired.front().version <= oldest)
+			{
+				delete retired.front().node;
+				retired.pop_front();
+			}
+		}
+
+		void get_surface_voxels_recursive(const node *node, voxel_set &voxels) const
+		{
+			if (!node->is_leaf())
+			{
+				for (auto child : node->children)
+				{
+					if (child)
+					{
+						get_surface_voxels_recursive(child, voxels);
+					}
+				}
+
+				return;
+			}
+
+			if (node->brick)
+			{
+				get_surface_brick_voxels(node, voxels);
+				return;
+			}
+
+			for (int face = 0; face < 6; face++)
+			{
+				if (!covered(node, static_cast<enum face>(face)))
+				{
+					for (const auto &voxel : node->voxels)
+					{
+						if (voxel.size > 0.0f)
+						{
+							voxels.push_back(voxel);
+						}
+					}
+
+					return;
+				}
+			}
 		}
 
-		void update_buffers(voxel_set data)
+		void get_surface_brick_voxels(const node *node, voxel_set &voxels) const
 		{
-			const size_t cube_vertex_count = 36;
-			size_t max_buffer_size = data.size();
-			size_t type_size = sizeof(glm::vec3);
+			const voxel_brick &brick = *node->brick;
 
-			// Resize the buffers and allocate memory
-			vertex_buffer->resize(cube_vertex_count * max_buffer_size * type_size);
-			color_buffer->resize(cube_vertex_count * max_buffer_size * type_size);
-			index_buffer->resize(cube_vertex_count * max_buffer_size * sizeof(unsigned int));
-
-			unsigned int *indices = new unsigned int[cube_vertex_count * max_buffer_size];
+			// a brick on the same level across a face has its own facing voxels to check
+			const voxel_brick *adjacent[6];
+			bool covered_faces[6];
 
-			int vertex_index = 0;
-			int index_offset = 0;
-
-			for (auto voxel : data)
+			for (int face = 0; face < 6; face++)
 			{
-				const float half_size = voxel.size / 2;
-				glm::vec3 center = voxel.position;
+				const class node *across = neighbor(node, static_cast<enum face>(face));
 
-				// Define the vertices for the cube
-				glm::vec3 vertices[] = {
-					center + glm::vec3(-half_size, -half_size, -half_size),
-					center + glm::vec3(half_size, -half_size, -half_size),
-					center + glm::vec3(half_size, half_size, -half_size),
-					center + glm::vec3(-half_size, half_size, -half_size),
-					center + glm::vec3(-half_size, -half_size, half_size),
-					center + glm::vec3(half_size, -half_size, half_size),
-					center + glm::vec3(half_size, half_size, half_size),
-					center + glm::vec3(-half_size, half_size, half_size)
-				};
+				adjacent[face] = across && across->brick && across->depth == node->depth ? across->brick.get() : nullptr;
+				covered_faces[face] = covered(node, static_cast<enum face>(face));
+			}
 
-				// Define the indices for the cube
-				unsigned int cube_indices[] = {
-					0, 1, 2, 2, 3, 0, // front face
-					1, 5, 6, 6, 2, 1, // right face
-					5, 4, 7, 7, 6, 5, // back face
-					4, 0, 3, 3, 7, 4, // left face
-					3, 2, 6, 6, 7, 3, // top face
-					4, 5, 1, 1, 0, 4 // bottom face
-				};
+			for (std::uint64_t bits = brick.occupancy; bits; bits &= bits - 1)
+			{
+				const int bit = std::countr_zero(bits);
+				const glm::ivec3 coord = voxel_brick::coord(bit);
 
-				for (int i = 0; i < cube_vertex_count; i++)
+				for (int face = 0; face < 6; face++)
 				{
-					glm::vec3 location = vertices[cube_indices[i]];
-
-					vertex_buffer->write(reinterpret_cast<void *>(&location), type_size, vertex_index * type_size);
-					color_buffer->write(reinterpret_cast<void *>(&voxel.color), type_size, vertex_index * type_size);
-
-					indices[index_offset + i] = vertex_index;
-					vertex_index++;
-				}
-
-				index_offset += cube_vertex_count;
-			}
+					const int axis = face / 2;
 
-			// Update the index buffer with the new indices
-			index_buffer->update(reinterpret_cast<void *>(indices));
+					glm::ivec3 across = coord;
+					across[axis] += (face & 1) ? 1 : -1;
 
-			delete[] indices;
-		}
+					bool exposed;
 
-		void draw()
-		{
-			if (vertex_buffer->get_size() != 0)
-			{
-				vertex_buffer->bind_vertex(0, 3);
-				color_buffer->bind_vertex(1, 3);
-				index_buffer->bind_indices();
+					if (across[axis] >= 0 && across[axis] < voxel_brick::extent)
+					{
+						exposed = !brick.contains(voxel_brick::bit(across));
+					}
+					else if (adjacent[face])
+					{
+						across[axis] = (across[axis] + voxel_brick::extent) % voxel_brick::extent;
+						exposed = !adjacent[face]->contains(voxel_brick::bit(across));
+					}
+					else
+					{
+						exposed = !covered_faces[face];
+					}
 
-				gfx::draw_elements(index_buffer->get_size());
-				gfx::draw_arrays(0, vertex_buffer->get_size());
+					if (exposed)
+					{
+						voxels.push_back(brick_voxel(node, bit));
+						break;
+					}
+				}
 			}
 		}
-	};
-
-	class svo
-	{
-public:
-		node *root;
 
 		/**
-		 * Constructs an SVO with a root voxel.
-		 *
-		 * @param position   The position of the root voxel.
-		 * @param color      The color of the root voxel.
-		 * @param root_size  The size of the root voxel.
+		 * Checks whether a leaf's face is hidden by whatever lies across it.
 		 *
-		 * @remarks This constructor initializes the SVO with a root voxel at the specified position, color, and size.
+		 * @remarks A brick only hides the face if it is full, since its voxels facing
+		 *          the leaf could be the empty ones.
 		 */
-		svo(const glm::vec3 &position, const glm::vec3 &color, float root_size)
-				: buffer(position)
+		[[nodiscard]] bool covered(const node *node, face face) const
 		{
-			root = new node();
-			root->position = position;
-			root->voxels[0] = voxel { position, color, root_size };
+			const class node *across = neighbor(node, face);
+
+			return across && (!across->brick || across->brick->full());
 		}
 
 		/**
-		 * Subdivides a node into eight children nodes.
+		 * Measures how far the empty space around an empty cell reaches.
 		 *
-		 * @param node  The node to subdivide.
+		 * @return The largest margin, in distance_hint_steps per cell, by which the cell
+		 *         can grow on every side without overlapping a voxel; at most max_distance_hint.
 		 *
-		 * @remarks This function subdivides the specified
-		 *          node into eight children nodes.
+		 * @remarks Growing the cell only ever adds voxels to the overlap, so the margin is
+		 *          found by binary search.
 		 */
-		void subdivide_node(node *node)
+		[[nodiscard]] std::uint8_t measure_distance(int level, const glm::ivec3 &coord)
 		{
-			const glm::vec3 &parent_pos = node->voxels[0].position;
-
-			float parent_size = node->voxels[0].size;
-			float child_size = parent_size / 2;
-
-			for (int i = 0; i < 8; i++)
-			{
-				glm::vec3 child_position = parent_pos;
-				glm::vec3 child_color = (node->voxels[0].color * (static_cast<float>(i) / 8));
-
-				child_position.x += (i & 1) ? child_size : -child_size;
-				child_position.y += (i & 2) ? child_size : -child_size;
-				child_position.z += (i & 4) ? child_size : -child_size;
-
-				node->children[i] = new class node();
-				node->children[i]->parent = node;
-				node->children[i]->position = child_position;
-				node->children[i]->voxels[0] = voxel { child_position, child_color, child_size };
-			}
-		}
+			int free = 0, blocked = max_distance_hint + 1;
 
-		void subdivide_recursively(node *node, int recursion_amount)
-		{
-			if (recursion_amount >= 1 && node)
+			while (blocked - free > 1)
 			{
-				subdivide_node(node);
+				int grow = (free + blocked) / 2;
 
-				for (int i = 0; i < 8; i++)
+				if (overlap(cell_bounds(level, coord, static_cast<float>(grow) / distance_hint_steps)))
+				{
+					blocked = grow;
+				}
+				else
 				{
-					subdivide_recursively(node->children[i], recursion_amount - 1);
+					free = grow;
 				}
 			}
-		}
 
-		/**
-		 * Constructs the octree recursively by subdividing nodes.
-		 *
-		 * @remarks This function constructs the octree recursively by subdividing nodes
-		 *          until the minimum voxel size is reached.
-		 */
-		void construct_octree()
-		{
-			construct_octree_recursive(root);
+			return static_cast<std::uint8_t>(free);
 		}
 
 		/**
-		 * Constructs the octree recursively by subdividing nodes.
-		 *
-		 * @param node  The current node being processed.
-		 *
-		 * @remarks This function constructs the octree recursively
-		 *          by subdividing nodes until the minimum voxel size
-		 *          for the sparse voxel octree is reached.
+		 * Recomputes the distance hint stored for one cell in its parent, if the cell is an empty child slot.
 		 */
-		void construct_octree_recursive(node *node)
+		void refresh_distance_hint(int level, const glm::ivec3 &coord)
 		{
-			if (node->voxels[0].size <= min_voxel_size)
+			node *parent = find(level - 1, coord >> 1);
+
+			if (!parent || parent->is_leaf())
 			{
 				return;
 			}
 
-			subdivide_node(node);
+			const glm::ivec3 bit = coord & 1;
+			const int slot = bit.x | bit.y << 1 | bit.z << 2;
+			const node *child = parent->children[slot];
 
-			for (int i = 0; i < 8; i++)
+			const std::uint8_t distance = child && child->coverage > 0.0f ? 0 : measure_distance(level, coord);
+
+			// most hints an edit rescans come out the same, and those nodes needn't be copied
+			if (parent->child_distance[slot] != distance)
 			{
-				if (node->children[i])
-				{
-					construct_octree_recursive(node->children[i]);
-				}
+				writable(parent)->child_distance[slot] = distance;
 			}
 		}
 
-		march_result march(ray::raycast &ray, float max_distance)
-		{
-			return march_recursive(ray, max_distance, root);
-		}
-
 		/**
-		 * Performs ray marching recursively through the octree to find the distance to the nearest surface.
+		 * Recomputes the hints of the empty slots close enough to a box to reach into it.
 		 *
-		 * @param ray           The ray to march.
-		 * @param max_distance  The maximum distance to march.
-		 * @param node          The current node being processed.
-		 * @return The distance to the nearest surface.
+		 * @param changed  The region whose occupancy an edit changed.
 		 *
-		 * @remarks This function performs ray marching recursively
-		 *          through the octree to find the distance to the nearest surface.
+		 * @remarks For edits that only add voxels: those can only shrink a hint whose reach
+		 *          takes in the box, so the others are left as they are. A hint reaches at
+		 *          most max_distance_hint / distance_hint_steps cells past its own cell, and
+		 *          cells halve with every level, so a subtree is only entered while its slots
+		 *          could still reach the box.
 		 */
-		march_result march_recursive(ray::raycast &ray, float max_distance, node *node)
+		void refresh_distance_hints_near(node *node, const collision::aabb &changed)
 		{
-			march_result result;
-			result.distance = std::numeric_limits<float>::max();
-			result.node = nullptr;
-
-			if (!node->children[0]) // check if the node is a leaf node
+			if (node->is_leaf())
 			{
-				for (int i = 0; i < 8; i++)
-				{
-					const auto &voxel = node->voxels[i];
-					if (voxel.size > 0.0f)
-					{
-						float t = ray.intersect_cube(voxel.position, voxel.size);
-						if (t >= 0.0f && t < result.distance)
-						{
-							result.distance = t;
-							result.hit = true;
-							result.node = node;
-							result.voxel = &voxel;
-						}
-					}
-				}
+				return;
 			}
-			else
+
+			const float reach = static_cast<float>(max_distance_hint) / distance_hint_steps;
+
+			for (int i = 0; i < 8; i++)
 			{
-				for (int i = 0; i < 8; i++)
+				const class node *child = node->children[i];
+				const glm::ivec3 coord = node->coord * 2 + glm::ivec3(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+
+				std::uint8_t distance = 0;
+
+				if (!child || child->coverage <= 0.0f)
 				{
-					const auto child = node->children[i];
+					const float hinted = static_cast<float>(node->child_distance[i]) / distance_hint_steps;
 
-					if (child)
+					if (!cell_bounds(node->depth + 1, coord, hinted).overlaps(changed))
 					{
-						float t = ray.intersect_cube(child->voxels[0].position, child->voxels[0].size);
-
-						if (t >= 0.0f && t < result.distance)
-						{
-							ray.set_origin(ray.get_origin() + ray.get_direction() * t);
+						continue;
+					}
 
-							march_result child_result = march_recursive(ray, max_distance - t, child);
+					distance = measure_distance(node->depth + 1, coord);
+				}
 
-							if (child_result.node != nullptr && child_result.distance < max_distance)
-							{
-								result.distance = t + child_result.distance;
-								result.hit = true;
-								result.node = child_result.node;
-								result.voxel = child_result.voxel;
-								break;
-							}
-						}
-					}
+				if (node->child_distance[i] != distance)
+				{
+					node = writable(node);
+					node->child_distance[i] = distance;
 				}
 			}
 
-			return result;
+			// a child's own slots are half its size, so they reach half as many of its cells
+			for (auto child : node->children)
+			{
+				if (child && child->coverage > 0.0f && cell_bounds(child->depth, child->coord, reach / 2).overlaps(changed))
+				{
+					refresh_distance_hints_near(child, changed);
+				}
+			}
 		}
 
-		int count_voxels(const node *node)
+		/**
+		 * Turns the subtrees two levels deep below a node into bricks.
+		 *
+		 * @return The height of the subtree below the node, or -1 if its leaves sit at
+		 *         different depths or it already holds a brick.
+		 */
+		int build_bricks_recursive(node *node, std::size_t &made)
 		{
-			if (!node)
+			if (node->brick)
 			{
-				return 0;
+				return -1;
 			}
 
-			int count = 1;
-
-			for (int i = 0; i < 8; i++)
+			if (node->is_leaf())
 			{
-				count += count_voxels(node->children[i]);
+				return 0;
 			}
 
-			return count;
-		}
+			int height = 0;
+			bool uneven = false;
 
-		void flatten_octree(const node *node, std::vector<voxel> &data, int &index)
-		{
-			if (!node)
+			for (auto child : node->children)
 			{
-				return;
-			}
+				if (child)
+				{
+					int child_height = build_bricks_recursive(child, made);
 
-			glm::vec3 node_position = root->position + node->position;
+					uneven = uneven || child_height < 0 || (height > 0 && child_height + 1 != height);
+					height = child_height + 1;
+				}
+			}
 
-			for (int i = 0; i < 8; i++)
+			if (uneven)
 			{
-				data[index].position = node_position + node->voxels[i].position;
-				data[index].color = node->voxels[i].color;
-				data[index].size = node->voxels[i].size;
-				index++;
+				return -1;
 			}
 
-			for (int i = 0; i < 8; i++)
+			if (height == 2)
 			{
-				flatten_octree(node->children[i], data, index);
+				pack_brick(node);
+				made++;
+
+				return -1;
 			}
+
+			return height;
 		}
 
-		void bind_to_gpu(buffer::buffer *buffer)
+		void pack_brick(node *node)
 		{
-			int numVoxels = count_voxels(root);
-			int current = 0;
+			node = writable(node);
 
-			std::vector<voxel> data(numVoxels);
-			flatten_octree(root, data, current);
+			auto brick = std::make_unique<voxel_brick>();
 
-			buffer->write(data.data(), sizeof(voxel) * numVoxels, 0);
-		}
+			for (int i = 0; i < 8; i++)
+			{
+				const class node *child = node->children[i];
 
-		void update_buffer(voxel_set data)
-		{
-			this->buffer.update_buffers(data);
-		}
+				for (int j = 0; child && j < 8; j++)
+				{
+					const class node *grandchild = child->children[j];
 
-		void draw_buffer()
-		{
-			this->buffer.draw();
+					if (grandchild && grandchild->voxels[0].size > 0.0f)
+					{
+						glm::ivec3 coord = glm::ivec3(i & 1, (i >> 1) & 1, (i >> 2) & 1) * 2 + glm::ivec3(j & 1, (j >> 1) & 1, (j >> 2) & 1);
+						brick->set(voxel_brick::bit(coord), grandchild->voxels[0].color);
+					}
+				}
+			}
+
+			destroy_children(node);
+			node->brick = std::move(brick);
 		}
 
-		void draw_node_buffer(glm::vec3 position_from, glm::vec3 direction, int depth, int draw_turn)
+		static std::size_t memory_usage_recursive(const node *node)
 		{
-			voxel_set voxels;
+			std::size_t bytes = sizeof(class node);
 
-			get_voxels_with_depth(root, draw_turn, depth, voxels);
+			if (node->brick)
+			{
+				bytes += sizeof(voxel_brick) + node->brick->colors.capacity() * sizeof(std::uint32_t);
+			}
 
-			if (voxels.size() > 0)
+			for (auto child : node->children)
 			{
-				update_buffer(voxels);
-				draw_buffer();
+				if (child)
+				{
+					bytes += memory_usage_recursive(child);
+				}
 			}
-		}
 
-		std::vector<voxel> get_voxels(int draw_turn)
-		{
-			voxel_set set;
-			get_voxels_with_depth(root, draw_turn, 1, set);
-			return set;
+			return bytes;
 		}
 
-		void get_voxels_with_depth(node *node, int draw_turn, int depth, voxel_set &voxels)
+		void compute_distance_hints_recursive(node *node)
 		{
-			if (!node || node->draw_turn != draw_turn)
+			if (node->is_leaf())
 			{
 				return;
 			}
 
-			if (depth <= 1)
+			for (int i = 0; i < 8; i++)
 			{
-				for (int i = 0; i < 8; i += 1)
+				const class node *child = node->children[i];
+				std::uint8_t distance = 0;
+
+				if (!child || child->coverage <= 0.0f)
+				{
+					glm::ivec3 coord = node->coord * 2 + glm::ivec3(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+					distance = measure_distance(node->depth + 1, coord);
+				}
+
+				if (node->child_distance[i] != distance)
 				{
-					voxels.push_back(node->voxels[i]);
+					node = writable(node);
+					node->child_distance[i] = distance;
 				}
 			}
-			else if (depth > 1)
+
+			// descending may replace this node with a copy, so nothing is written to it after this
+			for (auto child : node->children)
 			{
-				for (int i = 0; i < 8; i++)
+				if (child && child->coverage > 0.0f)
 				{
-					get_voxels_with_depth(node->children[i], draw_turn, depth - 1, voxels);
+					compute_distance_hints_recursive(child);
 				}
 			}
 		}
 
-private:
 		float min_voxel_size = 0.01f;
+		int min_parallel_reduce_levels = 5;
+
+		// the deepest level holding a node, and how many nodes each level holds
+		int max_depth = 0;
+		std::array<std::size_t, morton::max_level + 1> level_nodes {};
+
+		node_index index;
 		grid_buffer buffer;
+
+		struct retired_node {
+			// the first version that can't reach the node
+			std::uint64_t version;
+			class node *node;
+		};
+
+		// nodes made since the last publish have this version and are not shared yet
+		std::uint64_t editing_version = 1;
+
+		// replaced this round, and replaced in earlier rounds but possibly still read
+		std::vector<node *> replaced;
+		std::deque<retired_node> retired;
+
+		// behind a pointer so the svo can still be moved
+		std::unique_ptr<epoch_domain<node>> versions;
 	};
 };
@@ -0,0 +1,177 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace svo
+{
+	enum class vertex_format
+	{
+		// separate float position and color streams, 24 bytes per vertex
+		full,
+
+		// one interleaved stream of lattice positions and RGBA8 colors
+		compact_16,
+		compact_10_10_10,
+
+		// one static cube drawn once per voxel, from a voxel_instance each
+		instanced
+	};
+
+	/**
+	 * Maps integer lattice coordinates back to world space for one draw.
+	 *
+	 * world position = origin + lattice position * scale
+	 */
+	struct quantization {
+		glm::vec3 origin = glm::vec3(0.0f);
+		float scale = 1.0f;
+
+		[[nodiscard]] glm::mat4 model_matrix() const
+		{
+			glm::mat4 model(scale);
+			model[3] = glm::vec4(origin, 1.0f);
+
+			return model;
+		}
+	};
+
+	struct compact_mesh {
+		vertex_format format = vertex_format::compact_10_10_10;
+		quantization lattice;
+
+		// interleaved vertices, vertex_stride(format) bytes each
+		std::vector<std::byte> vertices;
+		std::vector<unsigned int> indices;
+	};
+
+	/**
+	 * One voxel of an instanced draw, on the same kind of lattice as the compact formats.
+	 *
+	 * @remarks Centers and sizes of voxels are whole multiples of half the smallest voxel
+	 *          size, so both are stored exactly whenever that lattice fits in 16 bits.
+	 */
+	struct voxel_instance {
+		// center, then edge length, in lattice steps; read as one vec4 by the shader
+		std::uint16_t position[3];
+		std::uint16_t size;
+
+		std::uint8_t color[4];
+	};
+
+	static_assert(sizeof(voxel_instance) <= 16, "instance records must stay within 16 bytes");
+
+	struct instance_mesh {
+		quantization lattice;
+		std::vector<voxel_instance> instances;
+	};
+
+	[[nodiscard]] constexpr std::size_t vertex_stride(vertex_format format)
+	{
+		switch (format)
+		{
+			case vertex_format::compact_16:
+				return 3 * sizeof(std::uint16_t) + sizeof(std::uint16_t) + sizeof(std::uint32_t);
+			case vertex_format::compact_10_10_10:
+				return sizeof(std::uint32_t) + sizeof(std::uint32_t);
+			case vertex_format::instanced:
+				return sizeof(voxel_instance);
+			default:
+				return 2 * sizeof(glm::vec3);
+		}
+	}
+
+	// offset of the RGBA8 color within a compact vertex
+	[[nodiscard]] constexpr std::size_t color_offset(vertex_format format)
+	{
+		return format == vertex_format::compact_16 ? 4 * sizeof(std::uint16_t) : sizeof(std::uint32_t);
+	}
+
+	[[nodiscard]] constexpr std::uint32_t max_lattice_coord(vertex_format format)
+	{
+		return format == vertex_format::compact_10_10_10 ? 0x3ff : 0xffff;
+	}
+
+	/**
+	 * Writes a lattice position and color as one compact vertex.
+	 *
+	 * @param out     Destination, vertex_stride(format) bytes.
+	 * @param format  compact_16 or compact_10_10_10.
+	 * @param coord   Lattice coordinate, each axis in [0, max_lattice_coord(format)].
+	 * @param color   Linear color in [0, 1], stored as RGBA8 with full alpha.
+	 */
+	inline void pack_vertex(std::byte *out, vertex_format format, const glm::uvec3 &coord, const glm::vec3 &color)
+	{
+		if (format == vertex_format::compact_16)
+		{
+			std::uint16_t position[4] = {
+				static_cast<std::uint16_t>(coord.x),
+				static_cast<std::uint16_t>(coord.y),
+				static_cast<std::uint16_t>(coord.z),
+				0
+			};
+
+			std::memcpy(out, position, sizeof(position));
+		}
+		else
+		{
+			// matches GL_UNSIGNED_INT_2_10_10_10_REV: x in the lowest bits
+			std::uint32_t position = (coord.x & 0x3ff) | (coord.y & 0x3ff) << 10 | (coord.z & 0x3ff) << 20;
+			std::memcpy(out, &position, sizeof(position));
+		}
+
+		glm::vec3 scaled = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+		std::uint8_t rgba[4] = {
+			static_cast<std::uint8_t>(scaled.x),
+			static_cast<std::uint8_t>(scaled.y),
+			static_cast<std::uint8_t>(scaled.z),
+			255
+		};
+
+		std::memcpy(out + color_offset(format), rgba, sizeof(rgba));
+	}
+
+	/**
+	 * Writes a voxel as one instance record.
+	 *
+	 * @param coord  Lattice coordinate of the center, each axis in [0, 0xffff].
+	 * @param size   Edge length in lattice steps, in [0, 0xffff].
+	 * @param color  Linear color in [0, 1], stored as RGBA8 with full alpha.
+	 */
+	[[nodiscard]] inline voxel_instance pack_instance(const glm::uvec3 &coord, std::uint32_t size, const glm::vec3 &color)
+	{
+		glm::vec3 scaled = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+
+		return voxel_instance {
+			{ static_cast<std::uint16_t>(coord.x), static_cast<std::uint16_t>(coord.y), static_cast<std::uint16_t>(coord.z) },
+			static_cast<std::uint16_t>(size),
+			{ static_cast<std::uint8_t>(scaled.x), static_cast<std::uint8_t>(scaled.y), static_cast<std::uint8_t>(scaled.z), 255 },
+		};
+	}
+
+	[[nodiscard]] inline glm::uvec3 unpack_coord(const std::byte *in, vertex_format format)
+	{
+		if (format == vertex_format::compact_16)
+		{
+			std::uint16_t position[4];
+			std::memcpy(position, in, sizeof(position));
+
+			return glm::uvec3(position[0], position[1], position[2]);
+		}
+
+		std::uint32_t position;
+		std::memcpy(&position, in, sizeof(position));
+
+		return glm::uvec3(position & 0x3ff, (position >> 10) & 0x3ff, (position >> 20) & 0x3ff);
+	}
+
+	[[nodiscard]] inline glm::vec3 unpack_color(const std::byte *in, vertex_format format)
+	{
+		std::uint8_t rgba[4];
+		std::memcpy(rgba, in + color_offset(format), sizeof(rgba));
+
+		return glm::vec3(rgba[0], rgba[1], rgba[2]) / 255.0f;
+	}
+}
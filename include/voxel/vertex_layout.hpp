@@ -0,0 +1,66 @@
+#pragma once
+#include <buffer.hpp>
+#include <cstddef>
+#include <render.hpp>
+#include <span>
+
+namespace svo
+{
+	/**
+	 * One attribute of an interleaved stream, as the shader reads it.
+	 */
+	struct vertex_attribute {
+		GLuint location;
+		GLint components;
+		GLenum type;
+		bool normalized;
+		std::size_t offset;
+	};
+
+	/**
+	 * Binds an interleaved vertex or instance stream to the shader attributes it feeds.
+	 *
+	 * @param buffer      The stream, holding one record every stride bytes.
+	 * @param stride      The size of one record.
+	 * @param attributes  Where each attribute sits in a record; the first one is bound through the buffer.
+	 * @param divisor     0 to advance the stream once per vertex, 1 to advance it once per instance.
+	 *
+	 * @remarks buffer::bind_vertex only describes tightly packed float streams, so it is used to
+	 *          bind the buffer and its layout is then replaced with the interleaved one.
+	 */
+	inline void bind_attributes(buffer::buffer *buffer, GLsizei stride, std::span<const vertex_attribute> attributes, GLuint divisor = 0)
+	{
+		buffer->bind_vertex(attributes.front().location, attributes.front().components);
+
+		for (const auto &attribute : attributes)
+		{
+			glEnableVertexAttribArray(attribute.location);
+			glVertexAttribPointer(attribute.location, attribute.components, attribute.type, attribute.normalized ? GL_TRUE : GL_FALSE, stride,
+				reinterpret_cast<const void *>(attribute.offset));
+			glVertexAttribDivisor(attribute.location, divisor);
+		}
+	}
+
+	/**
+	 * Undoes bind_attributes, so the next draw finds every attribute disabled and advancing per vertex.
+	 */
+	inline void unbind_attributes(std::span<const vertex_attribute> attributes)
+	{
+		for (const auto &attribute : attributes)
+		{
+			glVertexAttribDivisor(attribute.location, 0);
+			glDisableVertexAttribArray(attribute.location);
+		}
+	}
+
+	/**
+	 * Draws the bound index buffer once per instance, as gfx::draw_elements draws it once.
+	 *
+	 * @param index_count     The number of indices in one instance.
+	 * @param instance_count  The number of instances.
+	 */
+	inline void draw_elements_instanced(std::size_t index_count, std::size_t instance_count)
+	{
+		glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(index_count), GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(instance_count));
+	}
+}
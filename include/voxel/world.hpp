@@ -0,0 +1,140 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <voxel/svo.hpp>
+
+namespace world
+{
+	struct settings {
+		// half extent of each chunk's root node; chunk centers are twice this apart
+		float chunk_size = 1.0f;
+		int chunk_depth = 4;
+
+		// chunks kept around the camera's chunk, horizontally and vertically
+		int radius = 3;
+		int vertical_radius = 0;
+
+		// zero picks one worker per spare hardware thread
+		int worker_count = 0;
+
+		// caps the GL work spent on finished chunks each frame
+		int uploads_per_frame = 4;
+	};
+
+	struct chunk {
+		glm::ivec3 coord;
+		svo::svo octree;
+		svo::mesh_data mesh;
+
+		std::chrono::steady_clock::time_point requested;
+		bool uploaded = false;
+	};
+
+	struct stats {
+		std::size_t loaded = 0;
+		std::size_t pending = 0;
+		std::size_t generated = 0;
+
+		float chunks_per_second = 0.0f;
+		float average_latency_ms = 0.0f;
+		float max_latency_ms = 0.0f;
+	};
+
+	/**
+	 * Fills a chunk's octree with a height-field terrain.
+	 *
+	 * @param octree  The chunk's octree, holding just its root.
+	 * @param depth   How many levels to subdivide the chunk into.
+	 */
+	void generate_terrain(svo::svo &octree, int depth);
+
+	/**
+	 * A grid of independently built SVO chunks streamed around the camera.
+	 *
+	 * @remarks Chunks are generated and meshed on worker threads, nearest first.
+	 *          update and draw must be called from the thread owning the GL
+	 *          context, which is also where chunks are uploaded and where the GL
+	 *          buffers of retired chunks are freed. Their nodes are handed back to
+	 *          the workers to free, so a large retirement doesn't stall a frame.
+	 */
+	class chunk_world
+	{
+public:
+		bool enabled = false;
+
+		explicit chunk_world(const settings &settings);
+		~chunk_world();
+
+		chunk_world(const chunk_world &) = delete;
+		chunk_world &operator=(const chunk_world &) = delete;
+
+		/**
+		 * Schedules missing chunks, retires distant ones and uploads finished ones.
+		 *
+		 * @param camera_position  The position chunks are kept around.
+		 */
+		void update(const glm::vec3 &camera_position);
+
+		/**
+		 * Draws every uploaded chunk, one draw call per chunk.
+		 */
+		void draw();
+
+		[[nodiscard]] const stats &get_stats() const
+		{
+			return current_stats;
+		}
+
+		[[nodiscard]] const settings &get_settings() const
+		{
+			return config;
+		}
+
+private:
+		struct job {
+			glm::ivec3 coord;
+			std::chrono::steady_clock::time_point requested;
+		};
+
+		settings config;
+		stats current_stats;
+
+		std::unordered_map<std::uint64_t, std::unique_ptr<chunk>> chunks;
+		glm::ivec3 center_chunk = glm::ivec3(0);
+		bool has_center = false;
+
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable wake;
+		bool stopping = false;
+
+		// guarded by mutex
+		std::deque<job> pending;
+		std::unordered_set<std::uint64_t> scheduled;
+		std::vector<std::unique_ptr<chunk>> finished;
+
+		// retired chunks whose GL buffers are already freed, waiting for a worker to free their nodes
+		std::vector<std::unique_ptr<chunk>> discarded;
+
+		std::deque<std::chrono::steady_clock::time_point> recent_completions;
+		double total_latency_ms = 0.0;
+
+		void work();
+		void schedule(const glm::ivec3 &center);
+		void collect(const glm::ivec3 &center);
+		void retire(const glm::ivec3 &center);
+		void discard(std::vector<std::unique_ptr<chunk>> &&dropped);
+
+		[[nodiscard]] bool in_range(const glm::ivec3 &coord, const glm::ivec3 &center, int slack) const;
+		[[nodiscard]] glm::ivec3 chunk_of(const glm::vec3 &position) const;
+		[[nodiscard]] static std::uint64_t chunk_key(const glm::ivec3 &coord);
+	};
+}
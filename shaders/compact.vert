@@ -0,0 +1,14 @@
+#version 330 core
+
+// lattice coordinates; mvp includes the per-draw origin and scale
+layout(location = 0) in vec4 pos;
+layout(location = 1) in vec4 vertexColor;
+
+uniform mat4 mvp;
+  
+out vec3 fragmentColor;
+
+void main(){
+  gl_Position = mvp * vec4(pos.xyz, 1);
+  fragmentColor = vertexColor.rgb;
+}
@@ -0,0 +1,17 @@
+#version 330 core
+
+// unit cube corner, shared by every instance
+layout(location = 0) in vec3 corner;
+
+// per voxel, in lattice steps: center in xyz, edge length in w; mvp includes the per-draw origin and scale
+layout(location = 1) in vec4 instance;
+layout(location = 2) in vec4 instanceColor;
+
+uniform mat4 mvp;
+  
+out vec3 fragmentColor;
+
+void main(){
+  gl_Position = mvp * vec4(instance.xyz + corner * (instance.w * 0.5), 1);
+  fragmentColor = instanceColor.rgb;
+}
@@ -0,0 +1,475 @@
+#include <algorithm>
+#include <atomic>
+#include <bench.hpp>
+#include <chrono>
+#include <random>
+#include <spdlog/spdlog.h>
+#include <thread>
+#include <vector>
+#include <voxel/svo.hpp>
+#include <voxel/world.hpp>
+
+const static int BENCH_DEPTH = 6;
+const static int BENCH_LOOKUPS = 1 << 20;
+const static int BENCH_RAYS = 1 << 14;
+const static int BENCH_EDITS = 1 << 11;
+const static int BENCH_READERS = 3;
+const static int BENCH_READ_BATCH = 256;
+
+template<typename Function>
+static double time_ns_per(int iterations, Function &&function)
+{
+	auto start = std::chrono::steady_clock::now();
+	function();
+	auto elapsed = std::chrono::steady_clock::now() - start;
+
+	return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+// colors are stored as 8-bit channels
+const static float COLOR_STEP = 1.0f / 255.0f;
+
+/**
+ * Logs a benchmark result that is out of bounds.
+ *
+ * @return Whether the result was within bounds.
+ */
+static bool check(bool within_bounds, const char *what)
+{
+	if (!within_bounds)
+	{
+		spdlog::error("{} out of bounds", what);
+	}
+
+	return within_bounds;
+}
+
+static void bench_index_lookup()
+{
+	svo::svo octree(glm::vec3(0.0, 0.0, 0.0), glm::vec3(1.0, 0.5, 0.5), 1.0);
+	octree.subdivide_recursively(octree.root, BENCH_DEPTH);
+
+	std::mt19937 random(1337);
+	std::uniform_int_distribution<int> axis(0, (1 << BENCH_DEPTH) - 1);
+
+	std::vector<glm::ivec3> coords(BENCH_LOOKUPS);
+
+	for (auto &coord : coords)
+	{
+		coord = glm::ivec3(axis(random), axis(random), axis(random));
+	}
+
+	std::size_t hashed_hits = 0, descended_hits = 0, mismatches = 0;
+
+	double hashed = time_ns_per(BENCH_LOOKUPS, [&] {
+		for (const auto &coord : coords)
+		{
+			hashed_hits += octree.find(BENCH_DEPTH, coord) != nullptr;
+		}
+	});
+
+	double descended = time_ns_per(BENCH_LOOKUPS, [&] {
+		for (const auto &coord : coords)
+		{
+			descended_hits += octree.descend(BENCH_DEPTH, coord) != nullptr;
+		}
+	});
+
+	std::vector<svo::node *> leaves(coords.size());
+
+	for (std::size_t i = 0; i < coords.size(); i++)
+	{
+		leaves[i] = octree.find(BENCH_DEPTH, coords[i]);
+		mismatches += leaves[i] != octree.descend(BENCH_DEPTH, coords[i]);
+	}
+
+	std::size_t neighbours_found = 0;
+
+	double neighbours = time_ns_per(BENCH_LOOKUPS, [&] {
+		for (const auto *leaf : leaves)
+		{
+			neighbours_found += octree.neighbor(leaf, svo::face::pos_x) != nullptr;
+		}
+	});
+
+	spdlog::info("index lookup (depth {}): hashed {:.1f} ns, top-down {:.1f} ns, neighbour {:.1f} ns",
+			BENCH_DEPTH, hashed, descended, neighbours);
+	spdlog::info("index lookup hits: hashed {}, top-down {}, neighbours {}, mismatches {}",
+			hashed_hits, descended_hits, neighbours_found, mismatches);
+
+	octree.destroy();
+}
+
+static bool bench_vertex_packing()
+{
+	svo::svo octree(glm::vec3(0.0, 0.0, 0.0), glm::vec3(1.0, 0.5, 0.5), 1.0);
+	octree.subdivide_recursively(octree.root, BENCH_DEPTH);
+
+	svo::voxel_set voxels;
+	octree.get_surface_voxels(voxels);
+
+	svo::mesh_data full;
+	double full_ns = time_ns_per(static_cast<int>(voxels.size()), [&] { svo::grid_buffer::build_mesh(voxels, full); });
+
+	const std::size_t full_bytes = full.vertices.size() * sizeof(glm::vec3) * 2;
+
+	bool passed = true;
+
+	for (auto format : { svo::vertex_format::compact_16, svo::vertex_format::compact_10_10_10 })
+	{
+		svo::compact_mesh packed;
+		double packed_ns = time_ns_per(static_cast<int>(voxels.size()), [&] { svo::grid_buffer::pack_mesh(voxels, format, packed); });
+
+		// round trip every vertex back to world space and compare against the float mesh
+		const std::size_t stride = svo::vertex_stride(format);
+		float position_error = 0.0f, color_error = 0.0f;
+
+		for (std::size_t i = 0; i < full.vertices.size(); i++)
+		{
+			const std::byte *vertex = packed.vertices.data() + i * stride;
+
+			glm::vec3 position = packed.lattice.origin + glm::vec3(svo::unpack_coord(vertex, format)) * packed.lattice.scale;
+			glm::vec3 position_delta = glm::abs(position - full.vertices[i]);
+			glm::vec3 color_delta = glm::abs(svo::unpack_color(vertex, format) - full.colors[i]);
+
+			position_error = std::max({ position_error, position_delta.x, position_delta.y, position_delta.z });
+			color_error = std::max({ color_error, color_delta.x, color_delta.y, color_delta.z });
+		}
+
+		spdlog::info("vertex packing ({} B/vertex): {} -> {} bytes ({:.1f}x smaller), {:.1f} ns/voxel vs {:.1f} ns/voxel float",
+				stride, full_bytes, packed.vertices.size(), static_cast<double>(full_bytes) / packed.vertices.size(), packed_ns, full_ns);
+		spdlog::info("vertex packing ({} B/vertex) round trip: max position error {} (lattice step {}), max color error {}",
+				stride, position_error, packed.lattice.scale, color_error);
+
+		// 16-bit lattices hold every voxel corner exactly; 10-bit ones may have to round to the nearest step
+		const float position_bound = format == svo::vertex_format::compact_16 ? 0.0f : packed.lattice.scale * 0.5f;
+
+		passed = check(packed.lattice.scale > 0.0f, "vertex packing lattice step") && passed;
+		passed = check(position_error <= position_bound, "vertex packing position error") && passed;
+		passed = check(color_error <= COLOR_STEP, "vertex packing color error") && passed;
+	}
+
+	octree.destroy();
+
+	return passed;
+}
+
+static bool bench_instancing()
+{
+	svo::svo octree(glm::vec3(0.0, 0.0, 0.0), glm::vec3(1.0, 0.5, 0.5), 1.0);
+	world::generate_terrain(octree, BENCH_DEPTH);
+
+	// everything marked visible, collected one level above the leaves like the renderer's level of detail
+	svo::visibility_set visible;
+	octree.mark(octree.root, BENCH_DEPTH, visible);
+
+	svo::voxel_set voxels;
+	octree.get_voxels_with_depth(octree.root, visible, BENCH_DEPTH, voxels);
+
+	const double count = static_cast<double>(voxels.size());
+
+	svo::mesh_data full;
+	double full_ns = time_ns_per(static_cast<int>(voxels.size()), [&] { svo::grid_buffer::build_mesh(voxels, full); });
+
+	svo::instance_mesh instanced;
+	double instanced_ns = time_ns_per(static_cast<int>(voxels.size()), [&] { svo::grid_buffer::pack_instances(voxels, instanced); });
+
+	// what upload() sends for each
+	const std::size_t full_bytes = full.vertices.size() * sizeof(glm::vec3) * 2 + full.indices.size() * sizeof(unsigned int);
+	const std::size_t instanced_bytes = instanced.instances.size() * sizeof(svo::voxel_instance);
+
+	float position_error = 0.0f, size_error = 0.0f, color_error = 0.0f;
+
+	for (std::size_t i = 0; i < voxels.size(); i++)
+	{
+		const svo::voxel_instance &instance = instanced.instances[i];
+		const auto &lattice = instanced.lattice;
+
+		glm::vec3 position = lattice.origin + glm::vec3(instance.position[0], instance.position[1], instance.position[2]) * lattice.scale;
+		glm::vec3 color = glm::vec3(instance.color[0], instance.color[1], instance.color[2]) / 255.0f;
+
+		glm::vec3 position_delta = glm::abs(position - voxels[i].position);
+		glm::vec3 color_delta = glm::abs(color - voxels[i].color);
+
+		position_error = std::max({ position_error, position_delta.x, position_delta.y, position_delta.z });
+		size_error = std::max(size_error, std::abs(instance.size * lattice.scale - voxels[i].size));
+		color_error = std::max({ color_error, color_delta.x, color_delta.y, color_delta.z });
+	}
+
+	spdlog::info("instancing ({} voxels): {:.1f} B/voxel vs {:.1f} B/voxel expanded, {:.1f} ns/voxel vs {:.1f} ns/voxel expanded",
+			voxels.size(), instanced_bytes / count, full_bytes / count, instanced_ns, full_ns);
+	spdlog::info("instancing round trip: max position error {}, max size error {} (lattice step {}), max color error {}",
+			position_error, size_error, instanced.lattice.scale, color_error);
+
+	// the lattice is fitted to the voxels, so centers and sizes both land on it exactly
+	bool passed = check(instanced.lattice.scale > 0.0f, "instancing lattice step");
+	passed = check(position_error == 0.0f && size_error == 0.0f, "instancing position or size error") && passed;
+	passed = check(color_error <= COLOR_STEP, "instancing color error") && passed;
+
+	octree.destroy();
+
+	return passed;
+}
+
+// from a shell around the octree towards random points inside it
+static std::vector<ray::raycast> random_rays()
+{
+	std::mt19937 random(1337);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	std::vector<ray::raycast> rays;
+	rays.reserve(BENCH_RAYS);
+
+	for (int i = 0; i < BENCH_RAYS; i++)
+	{
+		glm::vec3 origin = glm::normalize(glm::vec3(unit(random), unit(random), unit(random))) * 3.0f;
+		glm::vec3 target = glm::vec3(unit(random), unit(random), unit(random));
+
+		rays.emplace_back(origin, glm::normalize(target - origin));
+	}
+
+	return rays;
+}
+
+static void bench_march(const char *scene, svo::svo &octree)
+{
+	auto rays = random_rays();
+
+	std::vector<svo::march_result> hinted(rays.size()), stepped(rays.size());
+
+	double hinted_ns = time_ns_per(BENCH_RAYS, [&] {
+		for (std::size_t i = 0; i < rays.size(); i++)
+		{
+			hinted[i] = octree.march(rays[i], 100.0f);
+		}
+	});
+
+	double stepped_ns = time_ns_per(BENCH_RAYS, [&] {
+		for (std::size_t i = 0; i < rays.size(); i++)
+		{
+			stepped[i] = octree.march(rays[i], 100.0f, false);
+		}
+	});
+
+	std::size_t hits = 0, mismatches = 0;
+	double hinted_steps = 0.0, stepped_steps = 0.0;
+
+	for (std::size_t i = 0; i < rays.size(); i++)
+	{
+		hits += hinted[i].hit;
+		mismatches += hinted[i].hit != stepped[i].hit || hinted[i].node != stepped[i].node;
+
+		hinted_steps += hinted[i].steps;
+		stepped_steps += stepped[i].steps;
+	}
+
+	spdlog::info("march ({}): {:.1f} steps/ray with hints vs {:.1f} without, {:.1f} ns/ray vs {:.1f} ns/ray",
+			scene, hinted_steps / BENCH_RAYS, stepped_steps / BENCH_RAYS, hinted_ns, stepped_ns);
+	spdlog::info("march ({}): {} of {} rays hit, mismatches {}", scene, hits, BENCH_RAYS, mismatches);
+}
+
+static void bench_empty_space_skipping()
+{
+	// every cell filled: rays stop on their first leaf
+	svo::svo dense(glm::vec3(0.0, 0.0, 0.0), glm::vec3(1.0, 0.5, 0.5), 1.0);
+	dense.subdivide_recursively(dense.root, BENCH_DEPTH);
+
+	// a height field: the upper half is open air
+	svo::svo terrain(glm::vec3(0.0, 0.0, 0.0), glm::vec3(1.0, 0.5, 0.5), 1.0);
+	world::generate_terrain(terrain, BENCH_DEPTH);
+
+	// a sparse scattering of single voxels, one in every few hundred cells
+	svo::svo open(glm::vec3(0.0, 0.0, 0.0), glm::vec3(1.0, 0.5, 0.5), 1.0);
+	open.subdivide_recursively(open.root, BENCH_DEPTH);
+
+	std::mt19937 random(1337);
+	std::uniform_int_distribution<int> keep(0, 255);
+
+	const int extent = 1 << BENCH_DEPTH;
+	std::vector<glm::ivec3> kept;
+
+	for (int x = 0; x < extent; x++)
+	{
+		for (int y = 0; y < extent; y++)
+		{
+			for (int z = 0; z < extent; z++)
+			{
+				if (keep(random) != 0)
+				{
+					open.remove_node(open.find(BENCH_DEPTH, glm::ivec3(x, y, z)));
+				}
+				else
+				{
+					kept.push_back(glm::ivec3(x, y, z));
+				}
+			}
+		}
+	}
+
+	open.compute_distance_hints();
+
+	bench_march("dense", dense);
+	bench_march("terrain", terrain);
+	bench_march("open", open);
+
+	// splitting a leaf grows its voxels, so the hints around it have to shrink with each edit
+	double subdivide_ns = time_ns_per(static_cast<int>(kept.size()), [&] {
+		for (const auto &coord : kept)
+		{
+			open.subdivide_node(open.find(BENCH_DEPTH, coord));
+		}
+	});
+
+	spdlog::info("march (open): {:.1f} us per subdivide keeping the hints exact", subdivide_ns / 1e3);
+	bench_march("open, subdivided", open);
+
+	dense.destroy();
+	terrain.destroy();
+	open.destroy();
+}
+
+static void bench_bricks()
+{
+	svo::svo octree(glm::vec3(0.0, 0.0, 0.0), glm::vec3(1.0, 0.5, 0.5), 1.0);
+	octree.subdivide_recursively(octree.root, BENCH_DEPTH);
+
+	const double solid_voxels = static_cast<double>(1 << (3 * BENCH_DEPTH));
+	auto rays = random_rays();
+
+	std::vector<svo::march_result> node_hits(rays.size()), brick_hits(rays.size());
+
+	auto trace = [&](std::vector<svo::march_result> &hits) {
+		return time_ns_per(BENCH_RAYS, [&] {
+			for (std::size_t i = 0; i < rays.size(); i++)
+			{
+				hits[i] = octree.march(rays[i], 100.0f);
+			}
+		});
+	};
+
+	std::size_t node_bytes = octree.memory_usage();
+	double node_ns = trace(node_hits);
+
+	std::size_t bricks = octree.build_bricks();
+
+	std::size_t brick_bytes = octree.memory_usage();
+	double brick_ns = trace(brick_hits);
+
+	// the same voxels either way, so every ray should hit at the same distance
+	std::size_t mismatches = 0;
+
+	for (std::size_t i = 0; i < rays.size(); i++)
+	{
+		mismatches += node_hits[i].hit != brick_hits[i].hit
+				|| (node_hits[i].hit && std::abs(node_hits[i].distance - brick_hits[i].distance) > 1e-4f);
+	}
+
+	spdlog::info("brick leaves (depth {}, {} bricks): {:.1f} B/voxel vs {:.1f} B/voxel as nodes",
+			BENCH_DEPTH, bricks, brick_bytes / solid_voxels, node_bytes / solid_voxels);
+	spdlog::info("brick leaves: {:.2f} Mrays/s vs {:.2f} Mrays/s as nodes, mismatches {}",
+			1e3 / brick_ns, 1e3 / node_ns, mismatches);
+
+	octree.destroy();
+}
+
+static void bench_snapshots()
+{
+	svo::svo octree(glm::vec3(0.0, 0.0, 0.0), glm::vec3(1.0, 0.5, 0.5), 1.0);
+	world::generate_terrain(octree, BENCH_DEPTH);
+	octree.publish();
+
+	const auto rays = random_rays();
+
+	std::atomic<bool> stopping = false;
+	std::atomic<std::size_t> marched = 0, changed = 0;
+
+	// each batch is marched twice on one snapshot, so an edit leaking into it would show up as a changed hit
+	auto read = [&](std::size_t offset) {
+		std::vector<ray::raycast> batch(rays.begin() + offset, rays.begin() + offset + BENCH_READ_BATCH);
+		std::vector<svo::march_result> first(batch.size());
+
+		while (!stopping.load(std::memory_order_relaxed))
+		{
+			auto snapshot = octree.read();
+
+			for (std::size_t i = 0; i < batch.size(); i++)
+			{
+				first[i] = snapshot.march(batch[i], 100.0f);
+			}
+
+			for (std::size_t i = 0; i < batch.size(); i++)
+			{
+				auto second = snapshot.march(batch[i], 100.0f);
+				changed += second.hit != first[i].hit || second.node != first[i].node || second.distance != first[i].distance;
+			}
+
+			marched += 2 * batch.size();
+		}
+	};
+
+	std::vector<std::thread> readers;
+
+	for (int i = 0; i < BENCH_READERS; i++)
+	{
+		readers.emplace_back(read, static_cast<std::size_t>(i * BENCH_READ_BATCH));
+	}
+
+	std::mt19937 random(1337);
+	std::uniform_int_distribution<int> axis(0, (1 << BENCH_DEPTH) - 1);
+
+	std::size_t peak_retired = 0;
+	auto start = std::chrono::steady_clock::now();
+
+	// carve and recolor random leaves, publishing after every edit
+	double edit_ns = time_ns_per(BENCH_EDITS, [&] {
+		for (int i = 0; i < BENCH_EDITS; i++)
+		{
+			svo::node *leaf = octree.find(BENCH_DEPTH, glm::ivec3(axis(random), axis(random), axis(random)));
+
+			if (leaf && i % 2 == 0)
+			{
+				octree.remove_node(leaf);
+			}
+			else if (leaf)
+			{
+				octree.set_color(leaf, glm::vec3(1.0f, 0.0f, 0.0f));
+			}
+
+			octree.publish();
+			peak_retired = std::max(peak_retired, octree.retired_count());
+		}
+	});
+
+	double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	stopping = true;
+
+	for (auto &reader : readers)
+	{
+		reader.join();
+	}
+
+	// nothing is reading anymore, so everything retired can go
+	octree.publish();
+
+	spdlog::info("snapshots ({} readers): {:.1f} us per edit and publish, {:.2f} Mrays/s marched meanwhile",
+			BENCH_READERS, edit_ns / 1e3, marched / elapsed_s / 1e6);
+	spdlog::info("snapshots: {} hits changed under a pinned snapshot, at most {} nodes awaiting reclaim, {} after the readers left",
+			changed.load(), peak_retired, octree.retired_count());
+
+	octree.destroy();
+}
+
+bool run_benchmarks()
+{
+	bool passed = true;
+
+	bench_index_lookup();
+	passed = bench_vertex_packing() && passed;
+	passed = bench_instancing() && passed;
+	bench_empty_space_skipping();
+	bench_bricks();
+	bench_snapshots();
+
+	return passed;
+}
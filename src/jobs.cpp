@@ -0,0 +1,329 @@
+#include <algorithm>
+#include <jobs.hpp>
+
+namespace jobs
+{
+	// lets a task submitted from inside the pool go to the submitting worker's own deque
+	static thread_local const pool *current_pool = nullptr;
+	static thread_local std::size_t current_worker = 0;
+
+	pool::pool(int worker_count)
+	{
+		if (worker_count <= 0)
+		{
+			worker_count = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+		}
+
+		for (int i = 0; i < worker_count; i++)
+		{
+			queues.push_back(std::make_unique<worker_queue>());
+		}
+
+		for (int i = 0; i < worker_count; i++)
+		{
+			workers.emplace_back(&pool::work, this, static_cast<std::size_t>(i));
+		}
+	}
+
+	pool::~pool()
+	{
+		{
+			std::lock_guard lock(sleep_mutex);
+			stopping = true;
+		}
+
+		wake.notify_all();
+
+		for (auto &worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	void pool::submit(std::function<void()> task)
+	{
+		std::size_t target = current_pool == this
+				? current_worker
+				: next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+
+		{
+			std::lock_guard lock(queues[target]->mutex);
+			queues[target]->tasks.push_back(std::move(task));
+		}
+
+		{
+			// counted under the sleep lock, so a worker about to wait can't miss it
+			std::lock_guard lock(sleep_mutex);
+			queued.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		wake.notify_one();
+	}
+
+	void pool::work(std::size_t self)
+	{
+		current_pool = this;
+		current_worker = self;
+
+		while (true)
+		{
+			std::function<void()> task;
+
+			if (try_take(self, task))
+			{
+				task();
+				continue;
+			}
+
+			std::unique_lock lock(sleep_mutex);
+			wake.wait(lock, [this] { return stopping || queued.load(std::memory_order_relaxed) > 0; });
+
+			if (stopping)
+			{
+				return;
+			}
+		}
+	}
+
+	bool pool::try_take(std::size_t self, std::function<void()> &task)
+	{
+		// newest first from our own deque, while it is still warm in cache
+		{
+			worker_queue &own = *queues[self];
+			std::lock_guard lock(own.mutex);
+
+			if (!own.tasks.empty())
+			{
+				task = std::move(own.tasks.back());
+				own.tasks.pop_back();
+				queued.fetch_sub(1, std::memory_order_relaxed);
+
+				return true;
+			}
+		}
+
+		// oldest first from everyone else's
+		for (std::size_t offset = 1; offset < queues.size(); offset++)
+		{
+			worker_queue &victim = *queues[(self + offset) % queues.size()];
+			std::lock_guard lock(victim.mutex);
+
+			if (!victim.tasks.empty())
+			{
+				task = std::move(victim.tasks.front());
+				victim.tasks.pop_front();
+				queued.fetch_sub(1, std::memory_order_relaxed);
+
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	frame_graph::frame_graph(int worker_count)
+			: workers(worker_count)
+	{
+	}
+
+	job &frame_graph::add(std::string name, affinity where, job_function function)
+	{
+		built = false;
+
+		return jobs.emplace_back(job { std::move(name), where, std::move(function) });
+	}
+
+	static bool touches(const std::vector<entt::id_type> &ids, entt::id_type id)
+	{
+		return std::find(ids.begin(), ids.end(), id) != ids.end();
+	}
+
+	static bool conflicts(const job &earlier, const job &later)
+	{
+		for (auto id : later.writes)
+		{
+			if (touches(earlier.reads, id) || touches(earlier.writes, id))
+			{
+				return true;
+			}
+		}
+
+		for (auto id : later.reads)
+		{
+			if (touches(earlier.writes, id))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void frame_graph::build()
+	{
+		if (built)
+		{
+			return;
+		}
+
+		dependencies.assign(jobs.size(), {});
+		dependents.assign(jobs.size(), {});
+
+		for (std::size_t later = 0; later < jobs.size(); later++)
+		{
+			for (std::size_t earlier = 0; earlier < later; earlier++)
+			{
+				// GL and ImGui calls keep their order even where no declared data is shared
+				bool both_render = jobs[earlier].where == affinity::render && jobs[later].where == affinity::render;
+
+				if (both_render || conflicts(jobs[earlier], jobs[later]))
+				{
+					dependencies[later].push_back(earlier);
+					dependents[earlier].push_back(later);
+				}
+			}
+		}
+
+		remaining = std::make_unique<std::atomic<int>[]>(jobs.size());
+		timings.assign(jobs.size(), job_timing {});
+
+		built = true;
+	}
+
+	void frame_graph::run(const frame::tick_event &event)
+	{
+		build();
+
+		if (jobs.empty())
+		{
+			return;
+		}
+
+		frame_start = std::chrono::steady_clock::now();
+		unfinished.store(jobs.size(), std::memory_order_relaxed);
+
+		for (std::size_t i = 0; i < jobs.size(); i++)
+		{
+			remaining[i].store(static_cast<int>(dependencies[i].size()), std::memory_order_relaxed);
+		}
+
+		for (std::size_t i = 0; i < jobs.size(); i++)
+		{
+			if (dependencies[i].empty())
+			{
+				dispatch(i, event);
+			}
+		}
+
+		// this thread only runs render jobs, and sleeps while the pool has the rest
+		while (true)
+		{
+			std::size_t index;
+
+			{
+				std::unique_lock lock(render_mutex);
+				render_ready.wait(lock, [this] { return !render_queue.empty() || unfinished.load(std::memory_order_acquire) == 0; });
+
+				if (render_queue.empty())
+				{
+					break;
+				}
+
+				index = render_queue.front();
+				render_queue.pop_front();
+			}
+
+			execute(index, event);
+			finish(index, event);
+		}
+
+		measure();
+	}
+
+	void frame_graph::dispatch(std::size_t index, const frame::tick_event &event)
+	{
+		if (jobs[index].where == affinity::render)
+		{
+			{
+				std::lock_guard lock(render_mutex);
+				render_queue.push_back(index);
+			}
+
+			render_ready.notify_one();
+			return;
+		}
+
+		// run blocks until every job has finished, so the event outlives the task
+		workers.submit([this, index, &event] {
+			execute(index, event);
+			finish(index, event);
+		});
+	}
+
+	void frame_graph::execute(std::size_t index, const frame::tick_event &event)
+	{
+		auto start = std::chrono::steady_clock::now();
+		jobs[index].function(event);
+		auto end = std::chrono::steady_clock::now();
+
+		timings[index] = job_timing {
+			std::chrono::duration<float, std::milli>(start - frame_start).count(),
+			std::chrono::duration<float, std::milli>(end - start).count(),
+		};
+	}
+
+	void frame_graph::finish(std::size_t index, const frame::tick_event &event)
+	{
+		// dependents go out before this job stops counting as unfinished, so the frame can't end early
+		for (std::size_t dependent : dependents[index])
+		{
+			if (remaining[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				dispatch(dependent, event);
+			}
+		}
+
+		// counted down under the lock, so run can't see the frame end and return while this
+		// thread is still about to signal
+		std::lock_guard lock(render_mutex);
+
+		if (unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			render_ready.notify_one();
+		}
+	}
+
+	void frame_graph::measure()
+	{
+		stats.jobs = timings;
+		stats.work_ms = 0.0f;
+
+		float first_start = timings[0].start_ms, last_end = 0.0f;
+
+		// jobs only depend on jobs added before them, so one pass in order sees every chain
+		std::vector<float> chain_ms(jobs.size(), 0.0f);
+		stats.critical_path_ms = 0.0f;
+
+		for (std::size_t i = 0; i < jobs.size(); i++)
+		{
+			const auto &timing = timings[i];
+
+			float longest_dependency = 0.0f;
+
+			for (std::size_t dependency : dependencies[i])
+			{
+				longest_dependency = std::max(longest_dependency, chain_ms[dependency]);
+			}
+
+			chain_ms[i] = longest_dependency + timing.duration_ms;
+
+			stats.critical_path_ms = std::max(stats.critical_path_ms, chain_ms[i]);
+			stats.work_ms += timing.duration_ms;
+
+			first_start = std::min(first_start, timing.start_ms);
+			last_end = std::max(last_end, timing.start_ms + timing.duration_ms);
+		}
+
+		stats.wall_ms = last_end - first_start;
+	}
+}
@@ -1,24 +1,68 @@
 #include "entt/signal/fwd.hpp"
 #include "render.hpp"
 #include "render_systems.hpp"
+#include <bench.hpp>
 #include <camera.hpp>
 #include <entity.hpp>
 #include <framework.hpp>
 #include <glm/gtx/string_cast.hpp>
+#include <jobs.hpp>
 #include <movement.hpp>
 #include <render.hpp>
+#include <replay.hpp>
 #include <shader.hpp>
 #include <spdlog/common.h>
 #include <spdlog/spdlog.h>
+#include <string>
+#include <string_view>
 #include <ui.hpp>
 #include <voxel/ray.hpp>
 #include <voxel/svo.hpp>
+#include <voxel/world.hpp>
 #include <window.hpp>
 
 using namespace entt::literals;
 
-int main()
+int main(int argc, char **argv)
 {
+	std::string record_path;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string_view arg = argv[i];
+
+		if (arg == "--bench")
+		{
+			return run_benchmarks() ? 0 : 1;
+		}
+
+		// --replay <path> [--report <csv>]
+		if (arg == "--replay" && i + 1 < argc)
+		{
+			std::string report = (i + 3 < argc && std::string_view(argv[i + 2]) == "--report") ? argv[i + 3] : "";
+			return replay::run(argv[i + 1], report);
+		}
+
+		// --diff <baseline csv> <candidate csv> [--threshold <percent>]
+		if (arg == "--diff" && i + 2 < argc)
+		{
+			double threshold = 5.0;
+
+			if (i + 4 < argc && std::string_view(argv[i + 3]) == "--threshold" && !replay::parse_number(argv[i + 4], threshold))
+			{
+				spdlog::error("--threshold expects a percentage, not {}", argv[i + 4]);
+				return 1;
+			}
+
+			return replay::diff(argv[i + 1], argv[i + 2], threshold);
+		}
+
+		if (arg == "--record" && i + 1 < argc)
+		{
+			record_path = argv[++i];
+		}
+	}
+
 	gfx::context context("voxel", 2560, 1440);
 
 	entt::registry registry = entt::basic_registry();
@@ -39,22 +83,42 @@ int main()
 		buffer::reserve_vertex_array(1);
 	}
 
-	svo::svo octree(glm::vec3(0.0, 0.0, 0.0), glm::vec3(1.0, 0.5, 0.5), 1.0);
 	gfx::camera camera(projection::perspective, 90.0f, 0.1f, 10000.0f);
 
-	octree.construct_octree();
-	octree.subdivide_recursively(octree.root, 4);
-
 	movement move;
 
-	registry.ctx().emplace<movement>();
-	registry.ctx().emplace<svo::svo>(octree);
+	// moved into the context, which owns the nodes from here on and hands out snapshots of them
+	auto &octree = registry.ctx().emplace<svo::svo>(create_scene());
+
+	// the scene's gaps are narrower than the player's box, so the player starts in front of it
+	// rather than at the origin, where every sweep would clip the first step against a voxel
+	const auto scene_bounds = svo::octree_view::subtree_bounds(octree.root);
+	const glm::vec3 scene_center = scene_bounds.center();
+
+	registry.ctx().emplace<movement>().position = glm::vec3(scene_center.x, scene_center.y, scene_bounds.min.z - 1.0f);
 	registry.ctx().emplace<gfx::camera>(camera);
+	registry.ctx().emplace<world::chunk_world>(world::settings {});
+
+	if (!record_path.empty())
+	{
+		registry.ctx().emplace<replay::recorder>(record_path);
+	}
+
 	registry.ctx().emplace<shader::shader>("shaders/simple.vert", "shaders/simple.frag");
+	registry.ctx().emplace_as<shader::shader>("compact_shader"_hs, "shaders/compact.vert", "shaders/simple.frag");
+	registry.ctx().emplace_as<shader::shader>("instanced_shader"_hs, "shaders/instanced.vert", "shaders/simple.frag");
+
+	// systems run as one job graph per frame, in this order wherever they share data;
+	// input comes first, so the camera has moved before this frame is drawn from it
+	auto &graph = registry.ctx().emplace<jobs::frame_graph>();
+
+	register_input(graph);
+	register_renderer(registry, graph);
+	register_gui(graph);
 
-	register_renderer(registry, dispatcher);
-	register_gui(dispatcher);
-	register_input(dispatcher);
+	dispatcher
+			.sink<frame::tick_event>()
+			.connect<&jobs::frame_graph::run>(graph);
 
 	framework.init_gui();
 	framework.run();
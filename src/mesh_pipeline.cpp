@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <voxel/mesh_pipeline.hpp>
+
+namespace svo
+{
+	mesh_pipeline::mesh_pipeline()
+	{
+		for (int slot = 0; slot < 2; slot++)
+		{
+			free_slots.try_push(std::move(slot));
+		}
+
+		worker = std::thread(&mesh_pipeline::work, this);
+	}
+
+	mesh_pipeline::~mesh_pipeline()
+	{
+		stopping.store(true, std::memory_order_release);
+		wake();
+
+		worker.join();
+	}
+
+	bool mesh_pipeline::submit(voxel_set &&voxels, int frame, vertex_format format)
+	{
+		submitted = true;
+
+		if (!requests.try_push(mesh_request { std::move(voxels), frame, format }))
+		{
+			stats.dropped_snapshots++;
+			return false;
+		}
+
+		wake();
+		return true;
+	}
+
+	void mesh_pipeline::work()
+	{
+		std::optional<mesh_request> request;
+		std::optional<int> slot;
+
+		while (true)
+		{
+			std::uint32_t observed = signal.load(std::memory_order_acquire);
+
+			if (stopping.load(std::memory_order_acquire))
+			{
+				return;
+			}
+
+			// only the newest snapshot is worth meshing; older ones are already out of date
+			while (auto next = requests.try_pop())
+			{
+				if (request)
+				{
+					superseded.fetch_add(1, std::memory_order_relaxed);
+				}
+
+				request = std::move(next);
+			}
+
+			if (request && !slot)
+			{
+				slot = free_slots.try_pop();
+			}
+
+			if (request && slot)
+			{
+				staged_mesh &mesh = staging[*slot];
+				mesh.format = request->format;
+
+				if (request->format == vertex_format::full)
+				{
+					grid_buffer::build_mesh(request->voxels, mesh.full);
+				}
+				else if (request->format == vertex_format::instanced)
+				{
+					grid_buffer::pack_instances(request->voxels, mesh.instanced);
+				}
+				else
+				{
+					grid_buffer::pack_mesh(request->voxels, request->format, mesh.compact);
+				}
+
+				ready.try_push(completed_mesh { *slot, request->frame });
+
+				request.reset();
+				slot.reset();
+
+				continue;
+			}
+
+			signal.wait(observed, std::memory_order_acquire);
+		}
+	}
+
+	void mesh_pipeline::wake()
+	{
+		signal.fetch_add(1, std::memory_order_release);
+		signal.notify_one();
+	}
+
+	void mesh_pipeline::release(int slot)
+	{
+		free_slots.try_push(std::move(slot));
+		wake();
+	}
+
+	void mesh_pipeline::record_latency(int frames)
+	{
+		stats.meshes_uploaded++;
+		stats.last_latency_frames = frames;
+		stats.max_latency_frames = std::max(stats.max_latency_frames, frames);
+
+		total_latency_frames += frames;
+		stats.average_latency_frames = static_cast<float>(total_latency_frames / stats.meshes_uploaded);
+	}
+}
@@ -4,11 +4,18 @@
 #include <glm/glm.hpp>
 #include <glm/gtx/string_cast.hpp>
 #include <movement.hpp>
+#include <replay.hpp>
 #include <shader.hpp>
+#include <voxel/svo.hpp>
 
 const static float MOVEMENT_SPEED = 30.0f;
 const static float MOUSE_SPEED = 150.0f;
 
+const static float PLAYER_HALF_EXTENT = 0.05f;
+const static float COLLISION_SKIN = 0.001f;
+const static int COLLISION_SLIDES = 3;
+const static std::chrono::microseconds COLLISION_BUDGET(250);
+
 struct poll_input_event {
 	entt::registry *registry;
 	frame::framework *framework;
@@ -17,33 +24,40 @@ struct poll_input_event {
 class movement_listener
 {
 	public:
-	void update_camera(const frame::tick_event &event)
+	void poll(const frame::tick_event &event)
 	{
 		auto registry = event.registry;
 		auto framework = event.data;
 
-		auto &move = registry->ctx().get<movement>();
-		auto &camera = registry->ctx().get<gfx::camera>();
-
-		auto &shader = registry->ctx().get<shader::shader>();
+		registry->ctx().get<movement>().velocity = glm::vec3(0.0f);
 
+		if (ImGui::GetCurrentContext() == nullptr || !ImGui::IsWindowFocused(ImGuiFocusedFlags_AnyWindow))
 		{
-			camera.move(move.position);
+			input(poll_input_event { registry, framework });
+		}
+	}
 
-			auto projection = camera.get_projection();
-			auto view = camera.get_view_matrix();
+	void collide(const frame::tick_event &event)
+	{
+		auto registry = event.registry;
+		auto &move = registry->ctx().get<movement>();
 
-			if (ImGui::GetCurrentContext() == nullptr || !ImGui::IsWindowFocused(ImGuiFocusedFlags_AnyWindow))
-			{
-				framework->dispatcher.trigger(
-						poll_input_event { registry, framework } // we could probably make a single poll_input_event instead of making a new one.
-				);
-			}
+		move.position += resolve_collision(registry->ctx().get<svo::svo>().read(), move.position, move.velocity);
+		move.velocity = glm::vec3(0.0f);
+	}
+
+	void update_camera(const frame::tick_event &event)
+	{
+		auto registry = event.registry;
 
-			glm::mat4 model = glm::mat4(1.0f);
-			glm::mat4 mvp = (projection * view * model);
+		auto &move = registry->ctx().get<movement>();
+		auto &camera = registry->ctx().get<gfx::camera>();
 
-			shader.bind_mat4("mvp", mvp, false);
+		camera.move(move.position);
+
+		if (auto recorder = registry->ctx().find<replay::recorder>())
+		{
+			recorder->record(move);
 		}
 	}
 
@@ -102,26 +116,77 @@ class movement_listener
 				{ input::key::shift, glm::vec3(0.0f, 1.0f, 0.0f) }	 // Down
 			};
 
+			glm::vec3 velocity(0.0f);
+
 			for (const auto &entry : keyToDirection)
 			{
 				if (framework->is_pressed(entry.first))
 				{
-					move.position += entry.second * MOVEMENT_SPEED * framework->frame.deltaTime;
+					velocity += entry.second * MOVEMENT_SPEED * framework->frame.deltaTime;
 				}
 			}
+
+			move.velocity = velocity;
 		}
 	}
-};
 
-void register_input(entt::dispatcher &dispatcher)
-{
-	movement_listener listener;
+	/**
+	 * Clips a player's displacement against the octree, sliding along whatever it hits.
+	 *
+	 * @remarks If the sweep does not finish within the collision budget, the player
+	 *          stays put for this frame rather than risk moving through a voxel.
+	 */
+	glm::vec3 resolve_collision(const svo::octree_view &svo, glm::vec3 position, glm::vec3 velocity)
+	{
+		const auto deadline = std::chrono::steady_clock::now() + COLLISION_BUDGET;
+		glm::vec3 travelled(0.0f);
 
-	dispatcher
-			.sink<frame::tick_event>()
-			.connect<&movement_listener::update_camera>(listener);
+		for (int slide = 0; slide < COLLISION_SLIDES && glm::dot(velocity, velocity) > 0.0f; slide++)
+		{
+			svo::sweep_query query {
+				collision::aabb::from_center(position + travelled, glm::vec3(PLAYER_HALF_EXTENT)),
+				velocity
+			};
+			svo::collision_result result;
+
+			auto budget = std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now());
+
+			if (svo.sweep_batch({ &query, 1 }, { &result, 1 }, budget) == 0)
+			{
+				return travelled;
+			}
 
-	dispatcher
-			.sink<poll_input_event>()
-			.connect<&movement_listener::input>(listener);
+			if (!result.hit)
+			{
+				return travelled + velocity;
+			}
+
+			// stop just short of the contact, then keep the part of the move along the surface
+			float length = glm::length(velocity);
+			float time = glm::max(0.0f, result.time - COLLISION_SKIN / length);
+
+			travelled += velocity * time;
+			velocity *= 1.0f - result.time;
+			velocity -= result.normal * glm::dot(velocity, result.normal);
+		}
+
+		return travelled;
+	}
+};
+
+void register_input(jobs::frame_graph &graph)
+{
+	// GLFW input has to be polled on the thread that owns the window
+	graph.add("input", jobs::affinity::render, [](const frame::tick_event &event) { movement_listener {}.poll(event); })
+			.writes_to<movement>()
+			.writes_to<gfx::camera>();
+
+	graph.add("collide", jobs::affinity::any, [](const frame::tick_event &event) { movement_listener {}.collide(event); })
+			.reads_from<svo::svo>()
+			.writes_to<movement>();
+
+	graph.add("camera", jobs::affinity::any, [](const frame::tick_event &event) { movement_listener {}.update_camera(event); })
+			.reads_from<movement>()
+			.writes_to<gfx::camera>()
+			.writes_to<replay::recorder>();
 }
@@ -3,85 +3,233 @@
 #include "framework.hpp"
 #include "render.hpp"
 #include "shader.hpp"
+#include "voxel/mesh_pipeline.hpp"
 #include "voxel/ray.hpp"
 #include "voxel/svo.hpp"
+#include "voxel/world.hpp"
 #include <render_systems.hpp>
 
 using namespace entt::literals;
 
+const static int VISIBLE_DEPTH = 4;
+
+svo::svo create_scene()
+{
+	svo::svo octree(glm::vec3(0.0, 0.0, 0.0), glm::vec3(1.0, 0.5, 0.5), 1.0);
+
+	octree.subdivide_recursively(octree.root, 4);
+
+	octree.publish();
+
+	return octree;
+}
+
+int mark_visible(const svo::octree_view &svo, const glm::vec3 &position, const glm::vec3 &direction, svo::visibility_set &visible)
+{
+	int nodes_drawn = 0;
+
+	ray::raycast cast(position, direction);
+
+	cast.set_origin(position);
+
+	const int min_yaw = -45, max_yaw = 45;
+	const int min_pitch = -45, max_pitch = 45;
+
+	const int multiplier = 500;
+	const int near_yaw_step = 1;
+	const int near_pitch_step = 1;
+
+	for (int yaw = min_yaw; yaw <= max_yaw; yaw += near_yaw_step)
+	{
+		float horizontalAngle = glm::radians(static_cast<float>(yaw));
+
+		for (int pitch = min_pitch; pitch <= max_pitch; pitch += near_pitch_step)
+		{
+			float verticalAngle = glm::radians(static_cast<float>(pitch));
+
+			cast.set_direction(
+					glm::rotate(glm::rotate(direction, verticalAngle * multiplier, glm::vec3(1.0f, 0.0f, 0.0f)),
+							horizontalAngle * multiplier, glm::vec3(0.0f, 1.0f, 0.0f)));
+
+			const float max_distance = 100.0f;
+			auto result = svo.march(cast, max_distance);
+
+			if (result.hit && !visible.contains(result.node->key()))
+			{
+				svo.mark(result.node, VISIBLE_DEPTH, visible);
+				nodes_drawn += 1;
+			}
+		}
+	}
+
+	return nodes_drawn;
+}
+
+void collect_visible(const svo::octree_view &svo, const svo::visibility_set &visible, svo::voxel_set &voxels)
+{
+	svo.get_voxels_with_depth(svo.root, visible, VISIBLE_DEPTH, voxels);
+}
+
 struct listener {
-	void tick_svo(const frame::tick_event &event)
+	void begin_frame(const frame::tick_event &event)
 	{
 		auto registry = event.registry;
-		auto framework = event.data;
-
-		auto &draw_turn = registry->ctx().get<int>("draw_turn"_hs);
-		auto &nodes_drawn = registry->ctx().get<int>("nodes_drawn"_hs);
 
 		auto &camera = registry->ctx().get<gfx::camera>();
-
 		auto &shader = registry->ctx().get<shader::shader>();
-		auto &svo = registry->ctx().get<svo::svo>();
 
 		gfx::clear(gfx::clear_buffer::Color | gfx::clear_buffer::Depth);
 		shader.bind();
 
-		nodes_drawn = 0;
-		draw_turn += 1;
+		glm::mat4 model = glm::mat4(1.0f);
+		glm::mat4 mvp = (camera.get_projection() * camera.get_view_matrix() * model);
+
+		shader.bind_mat4("mvp", mvp, false);
+	}
 
+	void update_world(const frame::tick_event &event)
+	{
+		auto registry = event.registry;
+
+		auto &camera = registry->ctx().get<gfx::camera>();
+		auto &world = registry->ctx().get<world::chunk_world>();
+
+		if (world.enabled)
 		{
-			glm::vec3 player_position = camera.get_position();
-			ray::raycast cast(player_position, camera.get_direction());
+			world.update(camera.get_position());
+			world.draw();
+		}
+	}
+
+	void find_visible(const frame::tick_event &event)
+	{
+		auto registry = event.registry;
 
-			cast.set_origin(player_position);
+		auto &draw_turn = registry->ctx().get<int>("draw_turn"_hs);
+		auto &nodes_drawn = registry->ctx().get<int>("nodes_drawn"_hs);
 
-			const int min_yaw = -45, max_yaw = 45;
-			const int min_pitch = -45, max_pitch = 45;
+		auto &camera = registry->ctx().get<gfx::camera>();
+		auto &visible = registry->ctx().get<svo::visibility_set>();
 
-			const int multiplier = 500;
-			const int near_yaw_step = 1;
-			const int near_pitch_step = 1;
+		// a snapshot, so an editor can keep changing the octree while this reads it
+		auto snapshot = registry->ctx().get<svo::svo>().read();
 
-			for (int yaw = min_yaw; yaw <= max_yaw; yaw += near_yaw_step)
-			{
-				float horizontalAngle = glm::radians(static_cast<float>(yaw));
+		draw_turn += 1;
+		visible.clear();
+
+		nodes_drawn = mark_visible(snapshot, camera.get_position(), camera.get_direction(), visible);
+	}
+
+	void submit_visible(const frame::tick_event &event)
+	{
+		auto registry = event.registry;
+
+		auto &draw_turn = registry->ctx().get<int>("draw_turn"_hs);
+		const auto &visible = registry->ctx().get<svo::visibility_set>();
+
+		// marks are node keys rather than pointers, so they still apply if a newer version was published since
+		auto snapshot = registry->ctx().get<svo::svo>().read();
+
+		// meshing runs on the pipeline's worker; the render thread only uploads and draws
+		auto &pipeline = registry->ctx().get<svo::mesh_pipeline>();
 
-				for (int pitch = min_pitch; pitch <= max_pitch; pitch += near_pitch_step)
-				{
-					float verticalAngle = glm::radians(static_cast<float>(pitch));
+		svo::voxel_set voxels;
+		collect_visible(snapshot, visible, voxels);
 
-					cast.set_direction(
-							glm::rotate(glm::rotate(camera.get_direction(), verticalAngle * multiplier, glm::vec3(1.0f, 0.0f, 0.0f)),
-									horizontalAngle * multiplier, glm::vec3(0.0f, 1.0f, 0.0f)));
+		pipeline.submit(std::move(voxels), draw_turn, registry->ctx().get<svo::vertex_format>());
+	}
+
+	void draw_svo(const frame::tick_event &event)
+	{
+		auto registry = event.registry;
+
+		auto &draw_turn = registry->ctx().get<int>("draw_turn"_hs);
 
-					const float max_distance = 100.0f;
-					auto result = svo.march(cast, max_distance);
+		auto &camera = registry->ctx().get<gfx::camera>();
 
-					float distance = result.distance;
+		auto &shader = registry->ctx().get<shader::shader>();
+		auto &svo = registry->ctx().get<svo::svo>();
 
-					glm::vec3 intersection_point = cast.get_origin() + cast.get_direction() * distance;
+		auto &pipeline = registry->ctx().get<svo::mesh_pipeline>();
 
-					if (result.hit && result.node->draw_turn != draw_turn)
-					{
-						result.node->set_draw_turn(draw_turn, 4);
-						nodes_drawn += 1;
-					}
-				}
+		pipeline.consume(draw_turn, [&](const svo::staged_mesh &mesh) {
+			if (mesh.format == svo::vertex_format::full)
+			{
+				svo.upload_mesh(mesh.full);
 			}
+			else if (mesh.format == svo::vertex_format::instanced)
+			{
+				svo.upload_mesh(mesh.instanced);
+			}
+			else
+			{
+				svo.upload_mesh(mesh.compact);
+			}
+		});
+
+		if (svo.get_buffer().get_format() == svo::vertex_format::full)
+		{
+			svo.draw_buffer();
 		}
+		else
+		{
+			// compact vertices and instances are lattice coordinates, so this draw needs its own transform
+			bool instanced = svo.get_buffer().get_format() == svo::vertex_format::instanced;
+			auto &lattice_shader = registry->ctx().get<shader::shader>(instanced ? "instanced_shader"_hs : "compact_shader"_hs);
+			glm::mat4 mvp = camera.get_projection() * camera.get_view_matrix() * svo.get_buffer().get_model_matrix();
+
+			lattice_shader.bind();
+			lattice_shader.bind_mat4("mvp", mvp, false);
 
-		svo.draw_node_buffer(camera.get_position(), camera.get_direction(), 4, draw_turn);
+			svo.draw_buffer();
+
+			shader.bind();
+		}
 	}
 };
 
-void register_renderer(entt::registry &registry, entt::dispatcher &dispatcher)
+void register_renderer(entt::registry &registry, jobs::frame_graph &graph)
 {
 	auto context = registry.ctx();
 
 	context.emplace_as<int>("draw_turn"_hs, 0);
 	context.emplace_as<int>("nodes_drawn"_hs, 0);
 
-	dispatcher
-			.sink<frame::tick_event>()
-			.connect<&listener::tick_svo>(listener {});
+	registry.ctx().emplace<svo::visibility_set>();
+
+	registry.ctx().emplace<svo::mesh_pipeline>();
+	registry.ctx().emplace<svo::vertex_format>(svo::vertex_format::full);
+
+	graph.add("clear", jobs::affinity::render, [](const frame::tick_event &event) { listener {}.begin_frame(event); })
+			.reads_from<gfx::camera>()
+			.reads_from<shader::shader>();
+
+	// chunk uploads need the GL context, so the world is drawn on the render thread
+	// while the pool works out what's visible in the main octree
+	graph.add("world", jobs::affinity::render, [](const frame::tick_event &event) { listener {}.update_world(event); })
+			.reads_from<gfx::camera>()
+			.writes_to<world::chunk_world>();
+
+	graph.add("visibility", jobs::affinity::any, [](const frame::tick_event &event) { listener {}.find_visible(event); })
+			.reads_from<gfx::camera>()
+			.reads_from<svo::svo>()
+			.writes_to<svo::visibility_set>()
+			.writes_to("draw_turn"_hs)
+			.writes_to("nodes_drawn"_hs);
+
+	graph.add("collect", jobs::affinity::any, [](const frame::tick_event &event) { listener {}.submit_visible(event); })
+			.reads_from<svo::svo>()
+			.reads_from<svo::visibility_set>()
+			.reads_from<svo::vertex_format>()
+			.reads_from("draw_turn"_hs)
+			.writes_to<svo::mesh_pipeline>();
+
+	graph.add("draw", jobs::affinity::render, [](const frame::tick_event &event) { listener {}.draw_svo(event); })
+			.reads_from<gfx::camera>()
+			.reads_from<shader::shader>()
+			.reads_from("compact_shader"_hs)
+			.reads_from("instanced_shader"_hs)
+			.reads_from("draw_turn"_hs)
+			.writes_to<svo::svo>()
+			.writes_to<svo::mesh_pipeline>();
 }
@@ -0,0 +1,253 @@
+#include <algorithm>
+#include <array>
+#include <camera.hpp>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <render_systems.hpp>
+#include <replay.hpp>
+#include <sstream>
+#include <spdlog/spdlog.h>
+
+namespace replay
+{
+	constexpr static std::array<const char *, 4> PHASES = { "visibility", "collect", "mesh", "total" };
+
+	typedef std::array<std::vector<double>, PHASES.size()> phase_samples;
+
+	recorder::recorder(const std::string &path)
+			: out(path)
+	{
+		if (!out)
+		{
+			spdlog::error("could not open {} for recording", path);
+		}
+	}
+
+	void recorder::record(const movement &move)
+	{
+		out << move.position.x << ' ' << move.position.y << ' ' << move.position.z << ' '
+			<< move.horizontalAngle << ' ' << move.verticalAngle << '\n';
+	}
+
+	std::vector<movement> load_path(const std::string &path)
+	{
+		std::vector<movement> frames;
+		std::ifstream in(path);
+
+		movement move;
+
+		while (in >> move.position.x >> move.position.y >> move.position.z >> move.horizontalAngle >> move.verticalAngle)
+		{
+			frames.push_back(move);
+		}
+
+		return frames;
+	}
+
+	bool parse_number(std::string_view text, double &value)
+	{
+		const char *end = text.data() + text.size();
+		auto [last, error] = std::from_chars(text.data(), end, value);
+
+		return error == std::errc() && last == end;
+	}
+
+	static double percentile(std::vector<double> samples, double fraction)
+	{
+		if (samples.empty())
+		{
+			return 0.0;
+		}
+
+		std::sort(samples.begin(), samples.end());
+
+		// nearest rank: the smallest sample with at least that fraction of samples at or below it;
+		// the epsilon keeps e.g. 0.95 * 100 from rounding up to rank 96
+		std::size_t rank = static_cast<std::size_t>(std::ceil(fraction * samples.size() - 1e-9));
+		return samples[std::clamp<std::size_t>(rank, 1, samples.size()) - 1];
+	}
+
+	static void log_summary(const std::string &name, const phase_samples &samples)
+	{
+		for (std::size_t phase = 0; phase < PHASES.size(); phase++)
+		{
+			const auto &values = samples[phase];
+
+			spdlog::info("{} {:>10}: p50 {:8.1f} us, p95 {:8.1f} us, p99 {:8.1f} us, max {:8.1f} us ({} frames)",
+					name, PHASES[phase], percentile(values, 0.50), percentile(values, 0.95), percentile(values, 0.99),
+					values.empty() ? 0.0 : *std::max_element(values.begin(), values.end()), values.size());
+		}
+	}
+
+	static bool load_report(const std::string &path, phase_samples &samples)
+	{
+		std::ifstream in(path);
+		std::string line;
+
+		if (!in || !std::getline(in, line))
+		{
+			spdlog::error("could not read replay report {}", path);
+			return false;
+		}
+
+		for (int line_number = 2; std::getline(in, line); line_number++)
+		{
+			if (line.empty())
+			{
+				continue;
+			}
+
+			std::istringstream fields(line);
+			std::string frame;
+			std::getline(fields, frame, ',');
+
+			for (std::size_t phase = 0; phase < PHASES.size(); phase++)
+			{
+				std::string field;
+				double value;
+
+				if (!std::getline(fields, field, ',') || !parse_number(field, value))
+				{
+					spdlog::error("replay report {} line {}: no valid {} timing", path, line_number, PHASES[phase]);
+					return false;
+				}
+
+				samples[phase].push_back(value);
+			}
+		}
+
+		// every percentile of an empty report would read as zero, which passes any gate
+		if (samples[0].empty())
+		{
+			spdlog::error("replay report {} has no frames", path);
+			return false;
+		}
+
+		return true;
+	}
+
+	int run(const std::string &path, const std::string &report)
+	{
+		auto frames = load_path(path);
+
+		if (frames.empty())
+		{
+			spdlog::error("no frames recorded in {}", path);
+			return 1;
+		}
+
+		std::ofstream out;
+
+		if (!report.empty())
+		{
+			out.open(report);
+
+			if (!out)
+			{
+				spdlog::error("could not open {} for the replay report", report);
+				return 1;
+			}
+
+			out << "frame,visibility_us,collect_us,mesh_us,total_us\n";
+		}
+
+		svo::svo octree = create_scene();
+		gfx::camera camera(projection::perspective, 90.0f, 0.1f, 10000.0f);
+
+		phase_samples samples;
+		svo::visibility_set marks;
+		svo::voxel_set visible;
+		svo::mesh_data mesh;
+
+		auto elapsed_us = [](auto start, auto end) { return std::chrono::duration<double, std::micro>(end - start).count(); };
+
+		for (std::size_t frame = 0; frame < frames.size(); frame++)
+		{
+			const movement &move = frames[frame];
+
+			// same camera update as movement_listener, minus the input polling
+			camera.move(move.position);
+			camera.rotate_to(move.horizontalAngle, -move.verticalAngle);
+
+			auto start = std::chrono::steady_clock::now();
+			marks.clear();
+			mark_visible(octree, camera.get_position(), camera.get_direction(), marks);
+
+			auto visibility_done = std::chrono::steady_clock::now();
+			visible.clear();
+			collect_visible(octree, marks, visible);
+
+			auto collect_done = std::chrono::steady_clock::now();
+			svo::grid_buffer::build_mesh(visible, mesh);
+
+			auto mesh_done = std::chrono::steady_clock::now();
+
+			std::array<double, PHASES.size()> timings = {
+				elapsed_us(start, visibility_done),
+				elapsed_us(visibility_done, collect_done),
+				elapsed_us(collect_done, mesh_done),
+				elapsed_us(start, mesh_done)
+			};
+
+			for (std::size_t phase = 0; phase < PHASES.size(); phase++)
+			{
+				samples[phase].push_back(timings[phase]);
+			}
+
+			if (out)
+			{
+				out << frame << ',' << timings[0] << ',' << timings[1] << ',' << timings[2] << ',' << timings[3] << '\n';
+			}
+		}
+
+		log_summary("replay", samples);
+
+		octree.destroy();
+		return 0;
+	}
+
+	int diff(const std::string &baseline, const std::string &candidate, double threshold_pct)
+	{
+		phase_samples before, after;
+
+		if (!load_report(baseline, before) || !load_report(candidate, after))
+		{
+			return 1;
+		}
+
+		// reports of the same path have the same frames; anything else isn't a like-for-like comparison
+		if (before[0].size() != after[0].size())
+		{
+			spdlog::error("replay reports cover {} and {} frames; both have to come from the same path",
+					before[0].size(), after[0].size());
+			return 1;
+		}
+
+		log_summary("baseline ", before);
+		log_summary("candidate", after);
+
+		bool regressed = false;
+
+		for (std::size_t phase = 0; phase < PHASES.size(); phase++)
+		{
+			for (double fraction : { 0.50, 0.95, 0.99 })
+			{
+				double old_value = percentile(before[phase], fraction);
+				double new_value = percentile(after[phase], fraction);
+				double change_pct = old_value > 0.0 ? (new_value - old_value) / old_value * 100.0 : 0.0;
+
+				spdlog::info("{:>10} p{:.0f}: {:8.1f} us -> {:8.1f} us ({:+.1f}%)", PHASES[phase], fraction * 100.0, old_value, new_value, change_pct);
+
+				// only the tail gates; medians are logged for context
+				if (fraction == 0.99 && change_pct > threshold_pct)
+				{
+					spdlog::warn("{} p99 regressed by {:.1f}%, over the {:.1f}% threshold", PHASES[phase], change_pct, threshold_pct);
+					regressed = true;
+				}
+			}
+		}
+
+		return regressed ? 1 : 0;
+	}
+}
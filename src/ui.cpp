@@ -2,8 +2,11 @@
 #include <camera.hpp>
 #include <entity.hpp>
 #include <glm/gtx/string_cast.hpp>
+#include <jobs.hpp>
 #include <render.hpp>
 #include <ui.hpp>
+#include <voxel/mesh_pipeline.hpp>
+#include <voxel/world.hpp>
 
 #include <framework.hpp>
 
@@ -46,6 +49,26 @@ class ui_listener
 					ImGui::Text("Nodes drawn: %i (%i vertices)", nodes_drawn, nodes_drawn * 12);
 					ImGui::Text("Memory usage %.2f/%.3f MB", total_mem_mb - cur_avail_mem_mb, total_mem_gb);
 
+					const auto &mesh_stats = registry->ctx().get<svo::mesh_pipeline>().get_stats();
+
+					ImGui::Text("Mesh latency: %i frames (%.2f avg, %i max)", mesh_stats.last_latency_frames, mesh_stats.average_latency_frames, mesh_stats.max_latency_frames);
+					ImGui::Text("Mesh upload: %.3f ms, stale frames: %zu", mesh_stats.last_upload_ms, mesh_stats.stale_frames);
+					ImGui::Text("Snapshots dropped: %zu, superseded: %zu", mesh_stats.dropped_snapshots, mesh_stats.superseded_snapshots);
+
+					auto &format = registry->ctx().get<svo::vertex_format>();
+					const auto &grid = registry->ctx().get<svo::svo>().get_buffer();
+
+					int selected_format = static_cast<int>(format);
+					const char *formats[] = { "float (24 B/vertex)", "16-bit lattice (12 B/vertex)", "10-10-10 lattice (8 B/vertex)", "instanced (12 B/voxel)" };
+
+					if (ImGui::Combo("Vertex format", &selected_format, formats, IM_ARRAYSIZE(formats)))
+					{
+						format = static_cast<svo::vertex_format>(selected_format);
+					}
+
+					ImGui::Text("Mesh upload: %.1f KB (%zu B/%s)", grid.get_uploaded_bytes() / 1024.0f, svo::vertex_stride(grid.get_format()),
+							grid.get_format() == svo::vertex_format::instanced ? "voxel" : "vertex");
+
 					ImGui::Text("camera.get_direction(): %s", glm::to_string(camera.get_direction()).c_str());
 
 					ImGui::Text("horizontalAngle: %.3f", move.horizontalAngle);
@@ -59,6 +82,39 @@ class ui_listener
 					ImGui::EndTabItem();
 				}
 
+				if (ImGui::BeginTabItem("World"))
+				{
+					auto &world = registry->ctx().get<world::chunk_world>();
+					const auto &stats = world.get_stats();
+
+					ImGui::Checkbox("Chunked world", &world.enabled);
+					ImGui::Text("Chunks loaded: %zu (%zu pending)", stats.loaded, stats.pending);
+					ImGui::Text("Chunks generated: %zu (%.1f chunks/s)", stats.generated, stats.chunks_per_second);
+					ImGui::Text("Build latency: %.2f ms avg, %.2f ms max", stats.average_latency_ms, stats.max_latency_ms);
+
+					ImGui::EndTabItem();
+				}
+
+				if (ImGui::BeginTabItem("Jobs"))
+				{
+					auto &graph = registry->ctx().get<jobs::frame_graph>();
+					const auto &stats = graph.get_stats();
+					const auto &job_list = graph.get_jobs();
+
+					ImGui::Text("Frame graph: %.3f ms wall, %.3f ms critical path", stats.wall_ms, stats.critical_path_ms);
+					ImGui::Text("Work: %.3f ms over all threads (%.2fx parallel)", stats.work_ms, stats.wall_ms > 0.0f ? stats.work_ms / stats.wall_ms : 0.0f);
+
+					for (std::size_t i = 0; i < stats.jobs.size() && i < job_list.size(); i++)
+					{
+						const auto &timing = stats.jobs[i];
+
+						ImGui::Text("%-10s %-6s start %.3f ms, took %.3f ms", job_list[i].name.c_str(),
+								job_list[i].where == jobs::affinity::render ? "render" : "pool", timing.start_ms, timing.duration_ms);
+					}
+
+					ImGui::EndTabItem();
+				}
+
 				if (ImGui::BeginTabItem("Controls"))
 				{
 					ImGui::EndTabItem();
@@ -72,9 +128,16 @@ class ui_listener
 	}
 };
 
-void register_gui(entt::dispatcher &dispatcher)
+void register_gui(jobs::frame_graph &graph)
 {
-	dispatcher
-			.sink<frame::tick_event>()
-			.connect<&ui_listener::update_gui>(ui_listener {});
+	// ImGui keeps its state per thread, and the frame it builds is drawn by the render thread
+	graph.add("gui", jobs::affinity::render, [](const frame::tick_event &event) { ui_listener {}.update_gui(event); })
+			.reads_from<gfx::camera>()
+			.reads_from<svo::svo>()
+			.writes_to<movement>()
+			.writes_to<svo::vertex_format>()
+			.writes_to<svo::mesh_pipeline>()
+			.writes_to<world::chunk_world>()
+			.reads_from("draw_turn"_hs)
+			.reads_from("nodes_drawn"_hs);
 }
@@ -0,0 +1,385 @@
+#include <algorithm>
+#include <cmath>
+#include <voxel/world.hpp>
+
+namespace world
+{
+	const static float TERRAIN_FREQUENCY = 2.5f;
+	const static float TERRAIN_AMPLITUDE = 0.4f;
+	const static glm::vec3 TERRAIN_LOW_COLOR = glm::vec3(0.45f, 0.3f, 0.15f);
+	const static glm::vec3 TERRAIN_HIGH_COLOR = glm::vec3(0.3f, 0.75f, 0.25f);
+
+	static float terrain_height(float x, float z)
+	{
+		return TERRAIN_AMPLITUDE * (std::sin(x * TERRAIN_FREQUENCY) + std::cos(z * TERRAIN_FREQUENCY * 0.7f));
+	}
+
+	void generate_terrain(svo::svo &octree, int depth)
+	{
+		octree.subdivide_recursively(octree.root, depth);
+
+		const int extent = 1 << depth;
+
+		for (int x = 0; x < extent; x++)
+		{
+			for (int z = 0; z < extent; z++)
+			{
+				for (int y = 0; y < extent; y++)
+				{
+					svo::node *node = octree.find(depth, glm::ivec3(x, y, z));
+
+					if (!node)
+					{
+						continue;
+					}
+
+					svo::voxel &voxel = node->voxels[0];
+					float height = terrain_height(voxel.position.x, voxel.position.z);
+
+					if (voxel.position.y > height)
+					{
+						// the reduce below covers every removal at once
+						octree.remove_node(node, false);
+						continue;
+					}
+
+					// every leaf was split off since the last publish, so no snapshot shares it and it is written in place
+					float blend = glm::clamp((voxel.position.y / TERRAIN_AMPLITUDE + 2.0f) * 0.25f, 0.0f, 1.0f);
+					voxel.color = glm::mix(TERRAIN_LOW_COLOR, TERRAIN_HIGH_COLOR, blend);
+				}
+			}
+		}
+
+		// already on a worker thread, so reduce serially rather than fanning out further
+		octree.reduce_attributes(octree.root, 0);
+
+		// the removals above only left short conservative hints behind
+		octree.compute_distance_hints();
+	}
+
+	chunk_world::chunk_world(const settings &settings)
+			: config(settings)
+	{
+		int worker_count = config.worker_count;
+
+		if (worker_count <= 0)
+		{
+			worker_count = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+		}
+
+		for (int i = 0; i < worker_count; i++)
+		{
+			workers.emplace_back(&chunk_world::work, this);
+		}
+	}
+
+	chunk_world::~chunk_world()
+	{
+		{
+			std::lock_guard lock(mutex);
+			stopping = true;
+		}
+
+		wake.notify_all();
+
+		for (auto &worker : workers)
+		{
+			worker.join();
+		}
+
+		for (auto &chunk : finished)
+		{
+			chunk->octree.destroy();
+		}
+
+		for (auto &chunk : discarded)
+		{
+			chunk->octree.destroy();
+		}
+
+		for (auto &[key, chunk] : chunks)
+		{
+			chunk->octree.destroy();
+		}
+	}
+
+	void chunk_world::update(const glm::vec3 &camera_position)
+	{
+		glm::ivec3 center = chunk_of(camera_position);
+
+		if (!has_center || center != center_chunk)
+		{
+			has_center = true;
+			center_chunk = center;
+
+			retire(center);
+			schedule(center);
+		}
+
+		collect(center);
+
+		int uploads = 0;
+
+		for (auto &[key, chunk] : chunks)
+		{
+			if (uploads >= config.uploads_per_frame)
+			{
+				break;
+			}
+
+			if (!chunk->uploaded)
+			{
+				chunk->octree.upload_mesh(chunk->mesh);
+				chunk->mesh = svo::mesh_data {};
+				chunk->uploaded = true;
+
+				uploads++;
+			}
+		}
+
+		// throughput over the last second of completions
+		auto now = std::chrono::steady_clock::now();
+
+		while (!recent_completions.empty() && now - recent_completions.front() > std::chrono::seconds(1))
+		{
+			recent_completions.pop_front();
+		}
+
+		current_stats.chunks_per_second = static_cast<float>(recent_completions.size());
+		current_stats.loaded = chunks.size();
+
+		std::lock_guard lock(mutex);
+		current_stats.pending = scheduled.size();
+	}
+
+	void chunk_world::draw()
+	{
+		for (auto &[key, chunk] : chunks)
+		{
+			if (chunk->uploaded)
+			{
+				chunk->octree.draw_buffer();
+			}
+		}
+	}
+
+	void chunk_world::work()
+	{
+		while (true)
+		{
+			job next;
+			std::vector<std::unique_ptr<chunk>> dropped;
+
+			{
+				std::unique_lock lock(mutex);
+				wake.wait(lock, [this] { return stopping || !pending.empty() || !discarded.empty(); });
+
+				if (stopping)
+				{
+					return;
+				}
+
+				// freeing comes first, so retired chunks don't pile up behind a long queue of new ones
+				if (!discarded.empty())
+				{
+					dropped.swap(discarded);
+				}
+				else
+				{
+					next = pending.front();
+					pending.pop_front();
+				}
+			}
+
+			if (!dropped.empty())
+			{
+				for (auto &chunk : dropped)
+				{
+					chunk->octree.destroy();
+				}
+
+				continue;
+			}
+
+			glm::vec3 center = glm::vec3(next.coord) * (config.chunk_size * 2.0f);
+
+			auto built = std::make_unique<chunk>(chunk {
+					next.coord,
+					svo::svo(center, TERRAIN_HIGH_COLOR, config.chunk_size),
+					svo::mesh_data {},
+					next.requested,
+			});
+
+			generate_terrain(built->octree, config.chunk_depth);
+
+			svo::voxel_set surface;
+			built->octree.get_surface_voxels(surface);
+			built->mesh = svo::grid_buffer::build_mesh(surface);
+
+			std::lock_guard lock(mutex);
+			finished.push_back(std::move(built));
+		}
+	}
+
+	void chunk_world::schedule(const glm::ivec3 &center)
+	{
+		std::vector<glm::ivec3> wanted;
+
+		for (int x = -config.radius; x <= config.radius; x++)
+		{
+			for (int y = -config.vertical_radius; y <= config.vertical_radius; y++)
+			{
+				for (int z = -config.radius; z <= config.radius; z++)
+				{
+					glm::ivec3 coord = center + glm::ivec3(x, y, z);
+
+					if (!chunks.contains(chunk_key(coord)))
+					{
+						wanted.push_back(coord);
+					}
+				}
+			}
+		}
+
+		// nearest first, so the chunks around the camera have the shortest latency
+		std::sort(wanted.begin(), wanted.end(), [&](const glm::ivec3 &a, const glm::ivec3 &b) {
+			glm::ivec3 da = a - center, db = b - center;
+			return glm::dot(glm::vec3(da), glm::vec3(da)) < glm::dot(glm::vec3(db), glm::vec3(db));
+		});
+
+		auto now = std::chrono::steady_clock::now();
+
+		{
+			std::lock_guard lock(mutex);
+
+			// chunks queued for a previous camera position are dropped; ones already being built finish
+			for (const auto &queued : pending)
+			{
+				scheduled.erase(chunk_key(queued.coord));
+			}
+
+			pending.clear();
+
+			for (const auto &coord : wanted)
+			{
+				if (scheduled.insert(chunk_key(coord)).second)
+				{
+					pending.push_back(job { coord, now });
+				}
+			}
+		}
+
+		wake.notify_all();
+	}
+
+	void chunk_world::collect(const glm::ivec3 &center)
+	{
+		std::vector<std::unique_ptr<chunk>> done;
+
+		{
+			std::lock_guard lock(mutex);
+			done.swap(finished);
+
+			for (const auto &chunk : done)
+			{
+				scheduled.erase(chunk_key(chunk->coord));
+			}
+		}
+
+		auto now = std::chrono::steady_clock::now();
+		std::vector<std::unique_ptr<chunk>> dropped;
+
+		for (auto &chunk : done)
+		{
+			float latency_ms = std::chrono::duration<float, std::milli>(now - chunk->requested).count();
+
+			current_stats.generated++;
+			current_stats.max_latency_ms = std::max(current_stats.max_latency_ms, latency_ms);
+
+			total_latency_ms += latency_ms;
+			current_stats.average_latency_ms = static_cast<float>(total_latency_ms / current_stats.generated);
+
+			recent_completions.push_back(now);
+
+			if (in_range(chunk->coord, center, 1))
+			{
+				chunks[chunk_key(chunk->coord)] = std::move(chunk);
+			}
+			else
+			{
+				dropped.push_back(std::move(chunk));
+			}
+		}
+
+		discard(std::move(dropped));
+	}
+
+	void chunk_world::retire(const glm::ivec3 &center)
+	{
+		std::vector<std::unique_ptr<chunk>> dropped;
+
+		// one chunk of slack, so moving back and forth over a border doesn't rebuild chunks
+		for (auto it = chunks.begin(); it != chunks.end();)
+		{
+			if (!in_range(it->second->coord, center, 1))
+			{
+				dropped.push_back(std::move(it->second));
+				it = chunks.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		discard(std::move(dropped));
+	}
+
+	void chunk_world::discard(std::vector<std::unique_ptr<chunk>> &&dropped)
+	{
+		if (dropped.empty())
+		{
+			return;
+		}
+
+		// only the GL buffers have to go on this thread; the nodes are left to the workers
+		for (auto &chunk : dropped)
+		{
+			chunk->octree.destroy_buffers();
+		}
+
+		{
+			std::lock_guard lock(mutex);
+
+			for (auto &chunk : dropped)
+			{
+				discarded.push_back(std::move(chunk));
+			}
+		}
+
+		wake.notify_one();
+	}
+
+	bool chunk_world::in_range(const glm::ivec3 &coord, const glm::ivec3 &center, int slack) const
+	{
+		glm::ivec3 offset = glm::abs(coord - center);
+
+		return offset.x <= config.radius + slack
+				&& offset.z <= config.radius + slack
+				&& offset.y <= config.vertical_radius + slack;
+	}
+
+	glm::ivec3 chunk_world::chunk_of(const glm::vec3 &position) const
+	{
+		return glm::ivec3(glm::floor((position + config.chunk_size) / (config.chunk_size * 2.0f)));
+	}
+
+	std::uint64_t chunk_world::chunk_key(const glm::ivec3 &coord)
+	{
+		// 21 bits per axis, offset so negative coordinates stay distinct
+		const std::uint64_t bias = 1 << 20;
+		const std::uint64_t mask = (1 << 21) - 1;
+
+		return ((coord.x + bias) & mask) | ((coord.y + bias) & mask) << 21 | ((coord.z + bias) & mask) << 42;
+	}
+}
@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <cstdio>
+#include <voxel/svo.hpp>
+#include <voxel/vertex_format.hpp>
+
+// colors are stored as 8-bit channels and rounded to the nearest one
+const static float COLOR_BOUND = 0.5f / 255.0f + 1e-6f;
+
+static int failures = 0;
+
+static void check(bool passed, const char *what)
+{
+	if (!passed)
+	{
+		std::fprintf(stderr, "FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+static float max_difference(const glm::vec3 &a, const glm::vec3 &b)
+{
+	glm::vec3 delta = glm::abs(a - b);
+	return std::max({ delta.x, delta.y, delta.z });
+}
+
+// every lattice coordinate a format can hold comes back unchanged, along with its color
+static void test_vertex_round_trip(svo::vertex_format format)
+{
+	const std::uint32_t max_coord = svo::max_lattice_coord(format);
+	std::byte vertex[16];
+
+	for (std::uint32_t value = 0; value <= max_coord; value += 1 + max_coord / 1024)
+	{
+		const glm::uvec3 coord(value, max_coord - value, value / 2);
+		const glm::vec3 color = glm::vec3(value % 256, (value * 7) % 256, (value * 13) % 256) / 255.0f + 0.001f;
+
+		svo::pack_vertex(vertex, format, coord, color);
+
+		check(svo::unpack_coord(vertex, format) == coord, "lattice coordinate round trip");
+		check(max_difference(svo::unpack_color(vertex, format), glm::clamp(color, 0.0f, 1.0f)) <= COLOR_BOUND, "vertex color within half an 8-bit step");
+	}
+
+	svo::pack_vertex(vertex, format, glm::uvec3(max_coord), glm::vec3(0.0f));
+	check(svo::unpack_coord(vertex, format) == glm::uvec3(max_coord), "largest lattice coordinate round trip");
+}
+
+// a mesh of voxels of mixed sizes comes back in world space within each format's bound
+static void test_mesh_round_trip()
+{
+	svo::svo octree(glm::vec3(0.0, 0.0, 0.0), glm::vec3(1.0, 0.5, 0.5), 1.0);
+	octree.subdivide_recursively(octree.root, 3);
+
+	for (int i = 0; i < 8; i++)
+	{
+		octree.subdivide_node(octree.find(3, glm::ivec3(i, i, 7 - i)));
+	}
+
+	svo::voxel_set voxels;
+	octree.get_surface_voxels(voxels);
+	check(!voxels.empty(), "scene has surface voxels");
+
+	svo::mesh_data full;
+	svo::grid_buffer::build_mesh(voxels, full);
+
+	for (auto format : { svo::vertex_format::compact_16, svo::vertex_format::compact_10_10_10 })
+	{
+		svo::compact_mesh packed;
+		svo::grid_buffer::pack_mesh(voxels, format, packed);
+
+		check(packed.lattice.scale > 0.0f, "mesh lattice step is positive");
+		check(packed.vertices.size() == full.vertices.size() * svo::vertex_stride(format), "one packed vertex per float vertex");
+
+		// 16-bit lattices hold every corner exactly; 10-bit ones may round to the nearest step
+		const float position_bound = format == svo::vertex_format::compact_16 ? 0.0f : packed.lattice.scale * 0.5f;
+		const std::size_t stride = svo::vertex_stride(format);
+
+		float position_error = 0.0f, color_error = 0.0f;
+
+		for (std::size_t i = 0; i < full.vertices.size(); i++)
+		{
+			const std::byte *vertex = packed.vertices.data() + i * stride;
+			glm::vec3 position = packed.lattice.origin + glm::vec3(svo::unpack_coord(vertex, format)) * packed.lattice.scale;
+
+			position_error = std::max(position_error, max_difference(position, full.vertices[i]));
+			color_error = std::max(color_error, max_difference(svo::unpack_color(vertex, format), full.colors[i]));
+		}
+
+		check(position_error <= position_bound, "mesh positions within the format's bound");
+		check(color_error <= COLOR_BOUND, "mesh colors within half an 8-bit step");
+	}
+
+	svo::instance_mesh instanced;
+	svo::grid_buffer::pack_instances(voxels, instanced);
+
+	check(instanced.lattice.scale > 0.0f, "instance lattice step is positive");
+	check(instanced.instances.size() == voxels.size(), "one instance per voxel");
+
+	for (std::size_t i = 0; i < voxels.size() && i < instanced.instances.size(); i++)
+	{
+		const svo::voxel_instance &instance = instanced.instances[i];
+		const auto &lattice = instanced.lattice;
+
+		glm::vec3 position = lattice.origin + glm::vec3(instance.position[0], instance.position[1], instance.position[2]) * lattice.scale;
+		glm::vec3 color = glm::vec3(instance.color[0], instance.color[1], instance.color[2]) / 255.0f;
+
+		check(position == voxels[i].position, "instance center is exact");
+		check(instance.size * lattice.scale == voxels[i].size, "instance size is exact");
+		check(max_difference(color, voxels[i].color) <= COLOR_BOUND, "instance color within half an 8-bit step");
+	}
+
+	octree.destroy();
+}
+
+int main()
+{
+	test_vertex_round_trip(svo::vertex_format::compact_16);
+	test_vertex_round_trip(svo::vertex_format::compact_10_10_10);
+	test_mesh_round_trip();
+
+	if (failures > 0)
+	{
+		std::fprintf(stderr, "%d checks failed\n", failures);
+		return 1;
+	}
+
+	return 0;
+}